@@ -2,6 +2,7 @@
 #include "ast.hpp"
 #include "type.hpp"
 #include "value.hpp"
+#include "table.hpp"
 
 #include "lang/debug.hpp"
 
@@ -20,6 +21,8 @@ init_nodes() {
   init_node(var_term, "var");
   init_node(abs_term, "abs");
   init_node(app_term, "app");
+  init_node(closure_term, "closure");
+  init_node(thunk_term, "thunk");
   init_node(tuple_term, "tuple");
   init_node(list_term, "list");
   init_node(record_term, "record");
@@ -28,6 +31,9 @@ init_nodes() {
   init_node(mem_term, "mem");
   init_node(col_term, "col");
   init_node(table_term, "table");
+  init_node(index_term, "index");
+  init_node(group_term, "group");
+  init_node(aggregate_term, "aggregate");
   init_node(and_term, "and");
   init_node(or_term, "or");
   init_node(not_term, "not");
@@ -142,6 +148,23 @@ pp_call(std::ostream& os, Call* t) {
   os << pretty(t->fn()) << '(' << commas(t->args()) << ')';
 }
 
+// A closure is printed as its function. The values bound by its
+// environment are not shown.
+void
+pp_closure(std::ostream& os, Closure* t) {
+  os << pretty(t->fn());
+}
+
+// A thunk is printed as its value, once it has one, and as its
+// argument otherwise.
+void
+pp_thunk(std::ostream& os, Thunk* t) {
+  if (t->value())
+    os << pretty(t->value());
+  else
+    os << pretty(t->term());
+}
+
 void
 pp_def(std::ostream& os, Def* t) {
   os << "def " << pretty(t->name()) << " = " << pretty(t->value());
@@ -162,6 +185,18 @@ pp_list(std::ostream& os, List* t) {
   os << '[' << commas(t->elems()) << ']';
 }
 
+// Print a table as a list of records.
+void
+pp_table(std::ostream& os, Table* t) {
+  os << '[';
+  for (std::size_t i = 0; i < t->rows(); ++i) {
+    if (i != 0)
+      os << ", ";
+    os << pretty(get_row(t, i));
+  }
+  os << ']';
+}
+
 void
 pp_record(std::ostream& os, Record* t) {
   os << '{' << commas(t->members()) << '}';
@@ -293,6 +328,27 @@ pp_except(std::ostream& os, Except* t) {
   os << pretty(t->t1) << " except " << pretty(t->t2);
 }
 
+void
+pp_index(std::ostream& os, Index* t) {
+  os << "index " << pretty(t->column());
+}
+
+void
+pp_group(std::ostream& os, Group* t) {
+  os << "group " << pretty(t->t1) << " from " << pretty(t->t2);
+}
+
+void
+pp_aggregate(std::ostream& os, Aggregate* t) {
+  switch (t->op) {
+  case count_agg: os << "count "; break;
+  case sum_agg: os << "sum "; break;
+  case min_agg: os << "min "; break;
+  case max_agg: os << "max "; break;
+  }
+  os << pretty(t->column());
+}
+
 // Print the wildcard type. Omit the explicit type qualifier
 // if the wildcard is actually a type variable.
 void
@@ -330,11 +386,14 @@ pp_expr(std::ostream& os, Node* t) {
   case fn_term: return pp_fn(os, as<Fn>(t));
   case app_term: return pp_app(os, as<App>(t));
   case call_term: return pp_call(os, as<Call>(t));
+  case closure_term: return pp_closure(os, as<Closure>(t));
+  case thunk_term: return pp_thunk(os, as<Thunk>(t));
   case ref_term: return pp_ref(os, as<Ref>(t));
   case def_term: return pp_def(os, as<Def>(t));
   case init_term: return pp_init(os, as<Init>(t));
   case tuple_term: return pp_tuple(os, as<Tuple>(t));
   case list_term: return pp_list(os, as<List>(t));
+  case table_term: return pp_table(os, as<Table>(t));
   case record_term: return pp_record(os, as<Record>(t));
   case comma_term: return pp_comma(os, as<Comma>(t));
   case proj_term: return pp_proj(os, as<Proj>(t));
@@ -350,6 +409,9 @@ pp_expr(std::ostream& os, Node* t) {
   case union_term: return pp_union(os, as<Union>(t));
   case intersect_term: return pp_intersect(os, as<Intersect>(t));
   case except_term: return pp_except(os, as<Except>(t));
+  case index_term: return pp_index(os, as<Index>(t));
+  case group_term: return pp_group(os, as<Group>(t));
+  case aggregate_term: return pp_aggregate(os, as<Aggregate>(t));
   case col_term: return pp_col(os, as<Col>(t));
   case join_on_term: return pp_join(os, as<Join>(t));
   // Types
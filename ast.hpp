@@ -9,8 +9,10 @@
 #include "lang/location.hpp"
 #include "lang/nodes.hpp"
 
+#include <atomic>
 #include <iosfwd>
 #include <map>
+#include <vector>
 
 // -------------------------------------------------------------------------- //
 // Language terms
@@ -43,6 +45,8 @@ constexpr Node_kind abs_term     = make_term_node(31); // \v.t
 constexpr Node_kind fn_term      = make_term_node(32); // \(v1, ..., vn).t
 constexpr Node_kind app_term     = make_term_node(33); // t1 t2
 constexpr Node_kind call_term    = make_term_node(34); // (t1, ..., tn)
+constexpr Node_kind closure_term = make_term_node(35); // <\x.t, E>
+constexpr Node_kind thunk_term   = make_term_node(36); // <t, E>
 // Tuples, records, and variants
 constexpr Node_kind tuple_term   = make_term_node(40); // {t1, ..., tn}
 constexpr Node_kind list_term    = make_term_node(41); // [t1, ..., tn]
@@ -62,6 +66,9 @@ constexpr Node_kind union_term   = make_term_node(63); // t1 union t2
 constexpr Node_kind intersect_term = make_term_node(64); // t1 intersect t2
 constexpr Node_kind except_term  = make_term_node(65); // t1 except t2
 constexpr Node_kind col_term     = make_term_node(66); // table.n (col proj)
+constexpr Node_kind index_term   = make_term_node(67); // index t1.x
+constexpr Node_kind group_term   = make_term_node(68); // group t1 from t2
+constexpr Node_kind aggregate_term = make_term_node(69); // count t1, sum t1, ...
 // Miscellaneous terms
 constexpr Node_kind ref_term     = make_term_node(100); // ref to decl
 constexpr Node_kind print_term   = make_term_node(101); // print t
@@ -99,17 +106,36 @@ struct Expr : Node {
     : Node(k), tr(t) { }
   Expr(Node_kind k, const Location& l, Type* t) 
     : Node(k, l), tr(t) { }
+
+  static constexpr bool has_kind(Node_kind k) {
+    return not is_util_node(k) and not is_tree_node(k);
+  }
+
   Type* tr;
 };
 
 // The base class of all identifiers in the language.
-struct Name : Expr { using Expr::Expr; };
+struct Name : Expr {
+  using Expr::Expr;
+
+  static constexpr bool has_kind(Node_kind k) { return is_name_node(k); }
+};
 
 // The base class of all types in the language.
-struct Type : Expr { using Expr::Expr; };
+struct Type : Expr {
+  using Expr::Expr;
+
+  static constexpr bool has_kind(Node_kind k) { return is_type_node(k); }
+};
 
 // The base class of all terms in the language.
-struct Term : Expr { using Expr::Expr; };
+struct Term : Expr {
+  using Expr::Expr;
+
+  static constexpr bool has_kind(Node_kind k) {
+    return is_term_node(k) and not is_tree_node(k);
+  }
+};
 
 // A sequence of expressions.
 using Expr_seq = Seq<Expr>;
@@ -120,6 +146,10 @@ using Term_seq = Seq<Term>;
 // A sequence of types.
 using Type_seq = Seq<Type>;
 
+// A sequence of table columns. Columns are defined in table.hpp.
+struct Column;
+using Column_seq = std::vector<Column*>;
+
 
 // -------------------------------------------------------------------------- //
 // Names
@@ -134,6 +164,8 @@ struct Id : Name {
   Id(const Location& l, String n)
     : Name(id_expr, l, nullptr), t1(n) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == id_expr; }
+
   String t1;
 };
 
@@ -146,6 +178,8 @@ struct Unit : Term {
     : Term(unit_term, t) { }
   Unit(const Location& l, Type* t) 
     : Term(unit_term, l, t) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == unit_term; }
 };
 
 // Represents the constant term 'true'.
@@ -154,6 +188,8 @@ struct True : Term {
     : Term(true_term, t) { }
   True(const Location& l, Type* t) 
     : Term(true_term, l, t) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == true_term; }
 };
 
 // Represents the constant term 'false'.
@@ -162,6 +198,8 @@ struct False : Term {
     : Term(false_term, t) { }
   False(const Location& l, Type* t) 
     : Term(false_term, l, t) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == false_term; }
 };
 
 // Represents the conditional term 'if t1 then t2 else t3'.
@@ -171,6 +209,8 @@ struct If : Term {
   If(const Location& l, Type* t, Term* t1, Term* t2, Term* t3) 
     : Term(if_term, l, t), t1(t1), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == if_term; }
+
   Term* cond() const { return t1; }
   Term* if_true() const { return t2; }
   Term* if_false() const { return t3; }
@@ -180,12 +220,15 @@ struct If : Term {
   Term* t3;
 };
 
-// Represents an integer literal.
+// Represents an integer literal. The value of the integer may be
+// stored outside the node, so it is destroyed with its arena.
 struct Int : Term {
   Int(Type* t, const Integer& n) 
-    : Term(int_term, t), t1(n) { }
+    : Term(int_term, t), t1(n) { destroy_in_arena(this); }
   Int(const Location& l, Type* t, const Integer& n) 
-    : Term(int_term, l, t), t1(n) { }
+    : Term(int_term, l, t), t1(n) { destroy_in_arena(this); }
+
+  static constexpr bool has_kind(Node_kind k) { return k == int_term; }
 
   const Integer& value() const { return t1; }
 
@@ -200,6 +243,8 @@ struct And :Term {
   And(const Location& l, Type* t, Term* t1, Term* t2)
     : Term(and_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == and_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -212,6 +257,8 @@ struct Or :Term {
   Or(const Location& l, Type* t, Term* t1, Term* t2)
     : Term(or_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == or_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -224,6 +271,8 @@ struct Not :Term {
   Not(const Location& l, Type* t, Term* t1)
     : Term(not_term, l, t), t1(t1) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == not_term; }
+
   Term* t1;
 };
 
@@ -234,6 +283,8 @@ struct Equals :Term {
   Equals(const Location& l, Type* t, Term* t1, Term* t2)
     : Term(equals_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == equals_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -245,6 +296,8 @@ struct Less :Term {
   Less(const Location& l, Type* t, Term* t1, Term* t2)
     : Term(less_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == less_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -256,6 +309,8 @@ struct Succ : Term {
   Succ(const Location& l, Type* t0, Term* t) 
     : Term(succ_term, l, t0), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == succ_term; }
+
   Term* arg() const { return t1; }
 
   Term* t1;
@@ -268,6 +323,8 @@ struct Pred : Term {
   Pred(const Location& l, Type* t0, Term* t) 
     : Term(pred_term, l, t0), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == pred_term; }
+
   Term* arg() const { return t1; }
 
   Term* t1;
@@ -280,6 +337,8 @@ struct Iszero : Term {
   Iszero(const Location& l, Type* t0, Term* t) 
     : Term(iszero_term, l, t0), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == iszero_term; }
+
   Term* arg() const { return t1; }
 
   Term* t1;
@@ -293,6 +352,8 @@ struct Str : Term {
   Str(const Location& l, Type* t, String s)
     : Term(str_term, l, t), t1(s) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == str_term; }
+
   String value() const { return t1; }
 
   String t1;
@@ -306,6 +367,8 @@ struct Var : Term {
   Var(const Location& l, Name* n, Type* t) 
     : Term(var_term, l, t), t1(n), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == var_term; }
+
   Name* name() const { return t1; }
   Type* type() const { return t2; }
 
@@ -321,6 +384,8 @@ struct Abs : Term {
   Abs(const Location& l, Type* t0, Term* x, Term* t) 
     : Term(abs_term, l, t0), t1(x), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == abs_term; }
+
   Term* var() const { return t1; }
   Term* term() const { return t2; }
 
@@ -337,6 +402,8 @@ struct Fn : Term {
   Fn(const Location& l, Type* t0, Term_seq* ps, Term* t) 
     : Term(fn_term, l, t0), t1(ps), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == fn_term; }
+
   Term_seq* parms() const { return t1; }
   Term* term() const { return t2; }
 
@@ -352,6 +419,8 @@ struct App : Term {
   App(const Location& l, Type* t0, Term* t1, Term* t2) 
     : Term(app_term, l, t0), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == app_term; }
+
   Term* abs() const { return t1; }
   Term* arg() const { return t2; }
 
@@ -367,6 +436,8 @@ struct Call : Term {
   Call(const Location& l, Type* t0, Term* t1, Term_seq* ts) 
     : Term(call_term, l, t0), t1(t1), t2(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == call_term; }
+
   Term* fn() const { return t1; }
   Term_seq* args() const { return t2; }
 
@@ -374,6 +445,49 @@ struct Call : Term {
   Term_seq* t2;
 };
 
+// An environment, binding the parameters of functions to the values
+// of their arguments. Environments are defined in env.hpp.
+struct Env;
+
+// A closure pairs a function (an abstraction or a multi-parameter
+// function) with the environment in which it was evaluated. Closures
+// are the function values of the environment-based evaluator; they
+// do not appear in elaborated programs.
+struct Closure : Term {
+  Closure(Type* t0, Term* f, Env* e)
+    : Term(closure_term, t0), t1(f), t2(e) { }
+  Closure(const Location& l, Type* t0, Term* f, Env* e)
+    : Term(closure_term, l, t0), t1(f), t2(e) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == closure_term; }
+
+  Term* fn() const { return t1; }
+  Env* env() const { return t2; }
+
+  Term* t1;
+  Env* t2;
+};
+
+// A thunk pairs an argument with the environment of the call that
+// passed it, and holds its value once it has been evaluated. Thunks
+// are the arguments of call-by-need evaluation; they do not appear in
+// elaborated programs.
+struct Thunk : Term {
+  Thunk(Type* t0, Term* t, Env* e)
+    : Term(thunk_term, t0), t1(t), t2(e) { }
+  Thunk(const Location& l, Type* t0, Term* t, Env* e)
+    : Term(thunk_term, l, t0), t1(t), t2(e) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == thunk_term; }
+
+  Term* term() const { return t1; }
+  Env* env() const { return t2; }
+  Term* value() const { return t3; }
+
+  Term* t1;
+  Env* t2;
+  Term* t3 = nullptr;
+};
 
 // A definition of the form 'def n = t'.
 //
@@ -385,6 +499,8 @@ struct Def : Term {
   Def(const Location& l ,Type* t, Name* n, Expr* v)
     : Term(def_term, l, t), t1(n), t2(v) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == def_term; }
+
   Name* name() const { return t1; }
   Expr* value() const { return t2; }
 
@@ -400,6 +516,8 @@ struct Init : Term {
   Init(const Location& l ,Type* t, Name* n, Expr* v)
     : Term(init_term, l, t), t1(n), t2(v) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == init_term; }
+
   Name* name() const { return t1; }
   Expr* value() const { return t2; }
 
@@ -414,9 +532,12 @@ struct Tuple : Term {
   Tuple(const Location& l, Type* t, Term_seq* ts)
     : Term(tuple_term, l, t), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == tuple_term; }
+
   Term_seq* elems() const { return t1; }
 
   Term_seq* t1;
+  std::atomic<bool> normal {false}; // True when known to be a value
 };
 
 // A list of the form '[t1, ..., tn]' where each 'ti' is a term.
@@ -426,9 +547,12 @@ struct List : Term {
   List(const Location& l, Type* t, Term_seq* ts)
     : Term(list_term, l, t), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == list_term; }
+
   Term_seq* elems() const { return t1; }
 
   Term_seq* t1;
+  std::atomic<bool> normal {false}; // True when known to be a value
 };
 
 // A record of the form '{n1=t1, ..., nn=tn}' where each ti is
@@ -442,9 +566,12 @@ struct Record : Term {
   Record(const Location& l, Type* t, Term_seq* ts)
     : Term(record_term, l, t), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == record_term; }
+
   Term_seq* members() const { return t1; }
 
   Term_seq* t1;
+  std::atomic<bool> normal {false}; // True when known to be a value
 };
 
 // A comma term of the form '(e1, ..., en)' is simply a sequence
@@ -456,6 +583,8 @@ struct Comma : Term {
   Comma(const Location& l, Type* t, Expr_seq* ts)
     : Term(comma_term, l, t), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == comma_term; }
+
   Expr_seq* elems() const { return t1; }
 
   Expr_seq* t1;
@@ -468,6 +597,8 @@ struct Proj : Term {
   Proj(const Location& l, Type* t, Term* t0, Term* n)
     : Term(proj_term, l, t), t1(t0), t2(n) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == proj_term; }
+
   Term* tuple() const { return t1; }
   Term* elem() const { return t2; }
 
@@ -482,6 +613,8 @@ struct Mem : Term {
   Mem(const Location& l, Type* t, Term* t0, Term* n)
     : Term(mem_term, l, t), t1(t0), t2(n) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == mem_term; }
+
   Term* record() const { return t1; }
   Term* member() const { return t2; }
 
@@ -496,6 +629,8 @@ struct Col : Term {
   Col(const Location& l, Type* t, Term* t0, Term* n)
     : Term(col_term, l, t), t1(t0), t2(n) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == col_term; }
+
   Term* table() const { return t1; }
   Term* attr() const { return t2; }
 
@@ -506,15 +641,27 @@ struct Col : Term {
 // Represefnts a reference to a declared entity in the program 
 // (e.g., a variable, function, etc). Note that the type of the
 // reference is the same as that of its referred-to expression.
+//
+// A reference to a parameter of an enclosing function also records
+// where the parameter is bound: its depth is the number of functions
+// between the reference and the one declaring the parameter, and its
+// slot is the position of the parameter in that function. For other
+// references, both are -1.
 struct Ref : Term {
   Ref(Expr* e)
     : Term(ref_term, e->tr), t1(e) { }
   Ref(const Location& l, Expr* e)
     : Term(ref_term, l, e->tr), t1(e) { }
+  Ref(const Location& l, Expr* e, int d, int s)
+    : Term(ref_term, l, e->tr), t1(e), depth(d), slot(s) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == ref_term; }
 
   Expr* decl() const { return t1; }
 
   Expr* t1;
+  int depth = -1;
+  int slot = -1;
 };
 
 // Prints an expression to the terminal.
@@ -524,6 +671,8 @@ struct Print : Term {
   Print(const Location& l, Type* t, Expr* e)
     : Term(print_term, l, t), t1(e) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == print_term; }
+
   Expr* expr() const { return t1; }
 
   Expr* t1;
@@ -534,6 +683,8 @@ struct Prog : Term {
   Prog(Type* t, Term_seq* ts)
     : Term(prog_term, t), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == prog_term; }
+
   Term_seq* stmts() const { return t1; }
 
   Term_seq* t1;
@@ -549,6 +700,8 @@ struct Select_from_where : Term {
   Select_from_where(const Location& l, Type* t, Term* t1, Term* t2, Term* t3)
     : Term(select_term, l, t), t1(t1), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == select_term; }
+
   Term* projection_list() const { return t1; }
   Term* table() const { return t2; }
   Term* cond() const { return t3; }
@@ -568,6 +721,8 @@ struct Join : Term {
   Join(const Location& l, Type* t, Term* t1, Term* t2, Term* t3)
     : Term(join_on_term, l, t), t1(t1), t2(t2), t3(t3){ }
 
+  static constexpr bool has_kind(Node_kind k) { return k == join_on_term; }
+
   Term* table_a() const { return t1; }
   Term* table_b() const { return t2; }
   Term* join_cond() const { return t3; }
@@ -585,6 +740,8 @@ struct Union: Term {
   Union(const Location&l, Type* t, Term* t1, Term* t2)
     : Term(union_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == union_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -597,6 +754,8 @@ struct Intersect : Term {
   Intersect(const Location&l, Type* t, Term* t1, Term* t2)
     : Term(intersect_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == intersect_term; }
+
   Term* t1;
   Term* t2;
 };
@@ -609,10 +768,94 @@ struct Except : Term {
   Except(const Location&l, Type* t, Term* t1, Term* t2)
     : Term(except_term, l, t), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == except_term; }
+
+  Term* t1;
+  Term* t2;
+};
+
+// index t1.x
+// Builds an index on the column x of the table defined by t1.
+struct Index : Term {
+  Index(Type* t, Term* t1)
+    : Term(index_term, t), t1(t1) { }
+  Index(const Location& l, Type* t, Term* t1)
+    : Term(index_term, l, t), t1(t1) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == index_term; }
+
+  Term* column() const { return t1; }
+
+  Term* t1;
+};
+
+// group t1 from t2
+// Groups the rows of the table t2 having the same values of the key
+// columns in t1. Each row of the result has those values and the
+// aggregates in t1 of the rows in a group.
+struct Group : Term {
+  Group(Type* t, Term* t1, Term* t2)
+    : Term(group_term, t), t1(t1), t2(t2) { }
+  Group(const Location& l, Type* t, Term* t1, Term* t2)
+    : Term(group_term, l, t), t1(t1), t2(t2) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == group_term; }
+
+  Term* group_list() const { return t1; }
+  Term* table() const { return t2; }
+
   Term* t1;
   Term* t2;
 };
 
+// The aggregate functions.
+enum Aggregate_op {
+  count_agg, // The number of rows
+  sum_agg,   // The sum of the values
+  min_agg,   // The least value
+  max_agg,   // The greatest value
+};
+
+// An aggregate of the form 'f t1', where t1 is a column of a table.
+// The variable names the aggregate in the rows of a grouping.
+struct Aggregate : Term {
+  Aggregate(Type* t, Aggregate_op op, Term* t1, Var* v)
+    : Term(aggregate_term, t), op(op), t1(t1), t2(v) { }
+  Aggregate(const Location& l, Type* t, Aggregate_op op, Term* t1, Var* v)
+    : Term(aggregate_term, l, t), op(op), t1(t1), t2(v) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == aggregate_term; }
+
+  Term* column() const { return t1; }
+  Var* var() const { return t2; }
+
+  Aggregate_op op;
+  Term* t1;
+  Var* t2;
+};
+
+// A table is the value of a list of records. The members of its
+// records are stored in columns, in the order they are declared by
+// the record type. The type of a table is a list type.
+//
+// The columns of a table are never modified once the table has been
+// constructed, so they can be shared by tables that project or merge
+// the same columns.
+struct Table : Term {
+  Table(Type* t, Column_seq* cs)
+    : Term(table_term, t), t1(cs) { }
+  Table(const Location& l, Type* t, Column_seq* cs)
+    : Term(table_term, l, t), t1(cs) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == table_term; }
+
+  Column_seq* columns() const { return t1; }
+  Column* column(std::size_t n) const { return (*t1)[n]; }
+  std::size_t rows() const;
+
+  Column_seq* t1;
+};
+
 // -------------------------------------------------------------------------- //
 // Types
 
@@ -622,6 +865,8 @@ struct Kind_type : Type {
     : Type(kind_type, nullptr) { }
   Kind_type(const Location& l)
     : Type(kind_type, l, nullptr) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == kind_type; }
 };
 
 // Represents the unit type.
@@ -630,6 +875,8 @@ struct Unit_type : Type {
     : Type(unit_type, k) { }
   Unit_type(const Location& l, Type* k)
     : Type(unit_type, l, k) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == unit_type; }
 };
 
 // Represents the bool type.
@@ -638,6 +885,8 @@ struct Bool_type : Type {
     : Type(bool_type, k) { }
   Bool_type(const Location& l, Type* k) 
     : Type(bool_type, l, k) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == bool_type; }
 };
 
 // Represents the nat type.
@@ -646,6 +895,8 @@ struct Nat_type : Type {
     : Type(nat_type, k) { }
   Nat_type(const Location& l, Type* k)
     : Type(nat_type, l, k) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == nat_type; }
 };
 
 // Represents the type of string vales.
@@ -654,6 +905,8 @@ struct Str_type : Type {
     : Type(str_type, k) { }
   Str_type(const Location& l, Type* k)
     : Type(str_type, l, k) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == str_type; }
 };
 
 // An arrow type of the form 'T1->T2'.
@@ -663,6 +916,8 @@ struct Arrow_type : Type {
   Arrow_type(const Location& l, Type* k, Type* t1, Type* t2)
     : Type(arrow_type, l, k), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == arrow_type; }
+
   Type* parm() const { return t1; }
   Type* result() const { return t2; }
 
@@ -677,6 +932,8 @@ struct Fn_type : Type {
   Fn_type(const Location& l, Type* k, Type_seq* ts, Type* t)
     : Type(fn_type, l, k), t1(ts), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == fn_type; }
+
   Type_seq* parms() const { return t1; }
   Type* result() const { return t2; }
 
@@ -691,6 +948,8 @@ struct Tuple_type : Type {
   Tuple_type(const Location& l, Type* k, Type_seq* ts)
     : Type(tuple_type, l, k), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == tuple_type; }
+
   Type_seq* types() const { return t1; }
 
   Type_seq* t1;
@@ -703,6 +962,8 @@ struct List_type : Type {
   List_type(const Location& l, Type* k, Type* ts)
     : Type(list_type, l, k), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == list_type; }
+
   Type* type() const { return t1; }
 
   Type* t1;
@@ -718,6 +979,8 @@ struct Record_type : Type {
   Record_type(const Location& l, Type* k, Term_seq* ts)
     : Type(record_type, l, k), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == record_type; }
+
   Term_seq* members() const { return t1; }
 
   Term_seq* t1;
@@ -733,6 +996,8 @@ struct Wild_type : Type {
   Wild_type(const Location& loc, Type* k, Name* n, Type* t)
     : Type(wild_type, loc, k), t1(n), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == wild_type; }
+
   Name* name() const { return t1; }
   Type* type() const { return t2; }
 
@@ -747,6 +1012,10 @@ struct Wild_type : Type {
 // Properties
 
 int size(Term*);
+std::size_t hash(Expr*);
+std::size_t hash_int(unsigned long);
+std::size_t hash_str(String);
+std::size_t hash_combine(std::size_t, std::size_t);
 
 // Relations
 bool is_same(Expr*, Expr*);
@@ -764,6 +1033,11 @@ struct Expr_less {
   bool operator()(Expr* e1, Expr* e2) const { return is_less(e1, e2); }
 };
 
+// A hash function for value terms, consistent with Expr_eq.
+struct Expr_hash {
+  std::size_t operator()(Expr* e) const { return hash(e); }
+};
+
 
 // -------------------------------------------------------------------------- //
 // Printing
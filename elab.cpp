@@ -96,12 +96,15 @@ elab_term(Tree* t) {
 //    G |- n : T
 //
 // The result of an elaborated id is a reference to its declaring
-// expression.
+// expression. A reference to a parameter also records the depth and
+// slot of its binding, so that evaluators can find its value without
+// searching for the declaration.
 Expr*
 elab_id(Id_tree* t) { 
   Name* name = elab_name(t);
-  if (Expr* decl = lookup(name))
-    return new Ref(t->loc, decl);
+  int depth, slot;
+  if (Expr* decl = lookup(name, depth, slot))
+    return new Ref(t->loc, decl, depth, slot);
   else
     error(t->loc) << format("no matching declaration for '{}'", pretty(name));
   return nullptr; 
@@ -140,11 +143,11 @@ elab_lit(Lit_tree* t) {
   case string_literal_tok:
     return new Str(t->loc, get_str_type(), as_string(*k));
   case unit_type_tok: 
-    return new Unit_type(t->loc, get_kind_type());
+    return get_unit_type();
   case bool_type_tok: 
-    return new Bool_type(t->loc, get_kind_type());
+    return get_bool_type();
   case nat_type_tok: 
-    return new Nat_type(t->loc, get_kind_type());
+    return get_nat_type();
   default: 
     break;
   }
@@ -226,15 +229,15 @@ elab_abs(Abs_tree* t) {
   Term* var = elab_term(t->var());
   if (not var)
     return nullptr;
+  current_scope()->parms.push_back(as<Var>(var));
   Term* term = elab_term(t->term());
   if (not term)
     return nullptr;
 
   // Create the result type.
-  Type* kind = get_kind_type();
   Type* t0 = get_type(var);
   Type* u0 = get_type(term);
-  Type* type = new Arrow_type(no_location, kind, t0, u0);
+  Type* type = get_arrow_type(t0, u0);
 
   // Create the abstraction.
   return new Abs(t->loc, type, var, term);
@@ -264,16 +267,16 @@ elab_fn(Fn_tree* t) {
       return nullptr;
     }
     parms->push_back(t1);
+    current_scope()->parms.push_back(as<Var>(t1));
   }
   Term* term = elab_term(t->term());
   if (not term)
     return nullptr;
 
   // Create the result type.
-  Type* kind = get_kind_type();
   Type_seq* t0 = get_type(parms);
   Type* u0 = get_type(term);
-  Type* type = new Fn_type(no_location, kind, t0, u0);
+  Type* type = get_fn_type(t0, u0);
 
   // Create the abstraction.
   return new Fn(t->loc, type, parms, term);
@@ -291,7 +294,7 @@ elab_app(App_tree* t, Term* fn, Term* arg, Arrow_type* fn_type) {
 
   // Check that t2 has the type of T in the type type T -> U.
   Type* arg_type = get_type(arg);
-  if (not is_same(arg_type, parm_type)) {
+  if (arg_type != parm_type) {
     error(arg->loc) << 
       format("argument '{}' (of type '{}') does not have type '{}'",
              pretty(arg),
@@ -360,7 +363,7 @@ elab_call(App_tree* t, Term* fn, Term* arg, Fn_type* fn_type) {
   while (arg_iter != arg_end) {
     Term* arg = *arg_iter;
     Type* parm = *parm_iter;
-    if (not is_same(get_type(arg), parm)) {
+    if (get_type(arg) != parm) {
       error(arg->loc) << format("argument {} does not have type '{}'",
                                 typed(arg),
                                 pretty(parm));
@@ -421,7 +424,7 @@ elab_if(If_tree* t) {
   // Check that t1 has type Bool.
   Type* bool_type = get_bool_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, get_bool_type())) {
+  if (type1 != get_bool_type()) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(bool_type));
     return nullptr;
@@ -430,7 +433,7 @@ elab_if(If_tree* t) {
   // Check that t2 and t3 have the same type.
   Type* type2 = get_type(t2);
   Type* type3 = get_type(t3);
-  if (not is_same(type2, type3)) {
+  if (type2 != type3) {
     error(t3->loc) << 
       format("term {} does not have type '{}'", typed(t3), pretty(type2));
     return nullptr;
@@ -456,7 +459,7 @@ elab_succ(Succ_tree* t) {
   // Check that t1 has type nat
   Type* nat_type = get_nat_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, nat_type)) {
+  if (type1 != nat_type) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(nat_type));
       return nullptr;
@@ -479,7 +482,7 @@ elab_pred(Pred_tree* t) {
   // Check that t1 has type nat
   Type* nat_type = get_nat_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, nat_type)) {
+  if (type1 != nat_type) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(nat_type));
       return nullptr;
@@ -502,7 +505,7 @@ elab_iszero(Iszero_tree* t) {
   // Check that t1 has type nat
   Type* nat_type = get_nat_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, nat_type)) {
+  if (type1 != nat_type) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(nat_type));
       return nullptr;
@@ -536,11 +539,10 @@ elab_arrow(Arrow_tree* t) {
     error(t2->loc) << format("'{}' does not name a type", pretty(t2));
     return nullptr;
   }
-  Type* kind_type = get_kind_type();
   Type* type1 = static_cast<Type*>(t1);
   Type* type2 = static_cast<Type*>(t2);
 
-  return new Arrow_type(t->loc, kind_type, type1, type2);
+  return get_arrow_type(type1, type2);
 }
 
 // Elaborate a tuple.
@@ -574,7 +576,7 @@ elab_tuple(Tuple_tree* t, Term* t0) {
     ++iter;
   }
 
-  Type* type = new Tuple_type(get_kind_type(), types);
+  Type* type = get_tuple_type(types);
   return new Tuple(t->loc, type, terms);
 }
 
@@ -606,7 +608,7 @@ elab_tuple_type(Tuple_tree* t, Type* t0) {
     ++iter;
   }
 
-  return new Tuple_type(t->loc, get_kind_type(), types);
+  return get_tuple_type(types);
 }
 
 
@@ -651,7 +653,7 @@ elab_record(Tuple_tree* t, Init* t0) {
     ++iter;
   }
 
-  Type* type = new Record_type(get_kind_type(), vars);
+  Type* type = get_record_type(vars);
   return new Record(t->loc, type, inits);
 }
 
@@ -683,7 +685,7 @@ elab_record_type(Tuple_tree* t, Var* t0) {
     ++iter;
   }
 
-  return new Record_type(get_kind_type(), vars);
+  return get_record_type(vars);
 }
 
 // Elaborate a tuple expression. Note that there are many
@@ -695,7 +697,7 @@ elab_record_type(Tuple_tree* t, Var* t0) {
 Expr*
 elab_tuple(Tuple_tree* t) {
   if (t->elems()->empty()) {
-    Tuple_type* type = new Tuple_type(get_kind_type(), new Type_seq());
+    Type* type = get_tuple_type(new Type_seq());
     return new Tuple(t->loc, type, new Term_seq());
   }
 
@@ -723,7 +725,7 @@ elab_list_type(List_tree* t, Type* t0) {
     error(t->loc) << format("ill-formed list type '{}'", pretty(t));
     return nullptr;
   }
-  return new List_type(get_kind_type(), t0);
+  return get_list_type(t0);
 }
 
 // Elaborate a list of terms.
@@ -737,7 +739,7 @@ elab_list(List_tree* t, Term* t0) {
   while (iter != end) {
     Expr* ei = elab_expr(*iter);
     if (Term* ti = as<Term>(ei)) {
-      if (!is_same (get_type(ti), value_type)) {
+      if (get_type(ti) != value_type) {
         error(ti->loc) << format("list element {} does not have type '{}'",
                                  typed(ti), 
                                  pretty(value_type));
@@ -753,7 +755,7 @@ elab_list(List_tree* t, Term* t0) {
     ++iter;
   }
 
-  Type* type = new List_type(get_kind_type(), value_type);
+  Type* type = get_list_type(value_type);
   return new List(t->loc, type, terms);
 }
 
@@ -774,8 +776,8 @@ Expr*
 elab_list(List_tree *t) {
   if (t->elems()->empty()) {
     Name* n = fresh_name();
-    Type* wild = new Wild_type(get_kind_type(), n, get_kind_type());
-    Type* type = new List_type(get_kind_type(), wild);
+    Type* wild = make_wild_type(n);
+    Type* type = get_list_type(wild);
     Term* list = new List(type, new Term_seq());
     return list;
   }
@@ -922,53 +924,253 @@ elab_dot(Dot_tree* t) {
   return nullptr;
 }
 
-// Elaboration for the table term
+// Returns the record type of the rows in t when t is a table, a list
+// of records. Otherwise, returns nullptr.
+Record_type*
+get_table_type(Type* t) {
+  if (List_type* l = as<List_type>(t))
+    return as<Record_type>(l->type());
+  return nullptr;
+}
+
+// Returns the member variable named by the column projection t, or
+// nullptr if t is not a column projection.
+Var*
+get_column_var(Expr* t) {
+  if (Mem* m = as<Mem>(t))
+    if (Ref* ref = as<Ref>(m->member()))
+      return as<Var>(ref->decl());
+  return nullptr;
+}
+
+// Elaborate an index statement.
+//
+//    def x = t   G |- x : [{l1:T1, ..., ln:Tn}]
+//    ------------------------------------------ T-index
+//            G |- index x.li : Unit
+//
+// Only the columns of tables bound by definitions can be indexed.
+Expr*
+elab_index(Index_tree* t) {
+  Term* t1 = elab_term(t->column());
+  if (not t1)
+    return nullptr;
+  Ref* table = nullptr;
+  if (Mem* m = as<Mem>(t1))
+    table = as<Ref>(m->record());
+  if (not table or not is<Def>(table->decl()) or not get_column_var(t1)
+      or not get_table_type(get_type(table))) {
+    error(t1->loc) << format("'{}' is not a column of a defined table", pretty(t1));
+    return nullptr;
+  }
+  return new Index(t->loc, get_unit_type(), t1);
+}
+
+// Elaborate a selection.
+//
+//    G |- t2 : [{R}]   G |- t1 : (t2.x1, ..., t2.xn)   G |- t3 : Bool
+//    ------------------------------------------------------------------ T-select
+//        G |- select t1 from t2 where t3 : [{x1:T1, ..., xn:Tn}]
+//
+// Each member of the projection list t1 names a column of t2. Each
+// row of the result has the named members of a row of t2.
 Expr*
-elab_select(Select_tree* t) { 
-  //elab the table
+elab_select(Select_tree* t) {
   Term* t2 = elab_term(t->t2);
+  if (not t2)
+    return nullptr;
+  if (not get_table_type(get_type(t2))) {
+    error(t2->loc) << format("'{}' is not a list of records", pretty(t2));
+    return nullptr;
+  }
 
-  //check for the table type
-  if (List_type* l_type = as<List_type>(get_type(t2))) {
-    if (Record_type* r_type = as<Record_type>(l_type->type())) {
+  Term* t1 = elab_term(t->t1);
+  if (not t1)
+    return nullptr;
+  Term* t3 = elab_term(t->t3);
+  if (not t3)
+    return nullptr;
 
+  // Collect the columns named by the projection list.
+  Term_seq* vars = new Term_seq();
+  Expr_seq* cols = new Expr_seq {t1};
+  if (Comma* c = as<Comma>(t1))
+    cols = c->elems();
+  for (Expr* e : *cols) {
+    Var* v = get_column_var(e);
+    if (not v) {
+      error(e->loc) << format("'{}' is not a column of '{}'", pretty(e), pretty(t2));
+      return nullptr;
     }
-    else
-      error(t->loc) << format("'{}' is not a list of records", pretty(t2));
+    vars->push_back(v);
   }
 
-  //elab the projection list
-  Term* t1 = elab_term(t->t1);
-  //elab the condition
-  Term* t3 = elab_term(t->t3);
+  // Check that t3 is a boolean condition.
+  Type* type_t3 = get_type(t3);
+  if (type_t3 != get_bool_type()) {
+    error(t3->loc) << format("mismatched types '{0}'", pretty(type_t3));
+    return nullptr;
+  }
+
+  Type* rec_type = get_record_type(vars);
+  Type* type = get_list_type(rec_type);
+  return new Select_from_where(t->loc, type, t1, t2, t3);
+}
+
+// Elaborate an aggregate of a column in a grouping.
+//
+//         G |- t : T                 G |- t : Nat
+//    ------------------- T-count    --------------- T-sum
+//    G |- count t : Nat             G |- sum t : Nat
+//
+//        G |- t : T                  G |- t : T
+//    -------------- T-min            -------------- T-max
+//    G |- min t : T                  G |- max t : T
+//
+// The operand names a column of the grouped table. In the rows of the
+// result, the aggregate is named by its function and that column
+// (e.g., 'sum_a').
+Expr*
+elab_aggregate(Aggregate_tree* t) {
+  Term* t1 = elab_term(t->expr());
+  if (not t1)
+    return nullptr;
+  Var* v = get_column_var(t1);
+  if (not v) {
+    error(t1->loc) << format("'{}' is not a column", pretty(t1));
+    return nullptr;
+  }
+
+  Aggregate_op op;
+  Type* type = v->type();
+  switch (kind(t->op())) {
+  case count_tok:
+    op = count_agg;
+    type = get_nat_type();
+    break;
+  case sum_tok:
+    op = sum_agg;
+    if (type != get_nat_type()) {
+      error(t1->loc) << format("mismatched types '{}'", pretty(type));
+      return nullptr;
+    }
+    break;
+  case min_tok:
+    op = min_agg;
+    break;
+  case max_tok:
+    op = max_agg;
+    break;
+  default:
+    lang_unreachable("unknown aggregate");
+  }
 
-  return new Select_from_where(get_kind_type(), t1, t2, t3);
+  std::string name = t->op()->text.str() + '_' + as<Id>(v->name())->t1.str();
+  Var* var = new Var(new Id(String(name)), type);
+  return new Aggregate(t->loc, type, op, t1, var);
 }
 
+// Elaborate a grouping.
+//
+//    G |- t2 : [{R}]   G |- t1 : (e1, ..., en)
+//    ------------------------------------------------ T-group
+//    G |- group t1 from t2 : [{x1:T1, ..., xn:Tn}]
+//
+// Each ei is either a column of t2, which is a key of the grouping, or
+// an aggregate of a column of t2. Each row of the result has the keys
+// of a group followed by its aggregates, in the order they are listed.
+Expr*
+elab_group(Group_tree* t) {
+  Term* t2 = elab_term(t->t2);
+  if (not t2)
+    return nullptr;
+  if (not get_table_type(get_type(t2))) {
+    error(t2->loc) << format("'{}' is not a list of records", pretty(t2));
+    return nullptr;
+  }
+
+  Tree_seq* items = new Tree_seq {t->t1};
+  if (Comma_tree* c = as<Comma_tree>(t->t1))
+    items = c->elems();
+  Expr_seq* elems = new Expr_seq();
+  Term_seq* vars = new Term_seq();
+  for (Tree* i : *items) {
+    if (Aggregate_tree* a = as<Aggregate_tree>(i)) {
+      Aggregate* e = as<Aggregate>(elab_aggregate(a));
+      if (not e)
+        return nullptr;
+      elems->push_back(e);
+      vars->push_back(e->var());
+      continue;
+    }
+    Term* e = elab_term(i);
+    if (not e)
+      return nullptr;
+    Var* v = get_column_var(e);
+    if (not v) {
+      error(e->loc) << format("'{}' is not a column of '{}'", pretty(e), pretty(t2));
+      return nullptr;
+    }
+    elems->push_back(e);
+    vars->push_back(v);
+  }
+
+  Term* t1 = as<Term>(elems->front());
+  if (elems->size() != 1)
+    t1 = new Comma(t->t1->loc, get_unit_type(), elems);
+  Type* rec_type = get_record_type(vars);
+  Type* type = get_list_type(rec_type);
+  return new Group(t->loc, type, t1, t2);
+}
+
+// Elaborate a join.
+//
+//    G |- t1 : [{R1}]   G |- t2 : [{R2}]   G |- t3 : Bool
+//    ---------------------------------------------------- T-join
+//             G |- t1 join t2 on t3 : [{R1, R2}]
+//
+// Each row of the result has the members of a row of t1 followed by
+// those of a matching row of t2.
 Expr*
 elab_join(Join_on_tree* t) {
   Term* t1 = elab_term(t->t1);
+  if (not t1)
+    return nullptr;
   Term* t2 = elab_term(t->t2);
+  if (not t2)
+    return nullptr;
   Term* t3 = elab_term(t->t3);
+  if (not t3)
+    return nullptr;
 
-  Type* type_t1 = get_type(t1);
-  Type* type_t2 = get_type(t2);
-
-  //check that t1 and t2 are the same type
-  if(!is_same(type_t1, type_t2))
-    error(t->loc) << format("mismatched types '{0}' and '{1}'", 
-                            pretty(type_t1), 
-                            pretty(type_t2));
+  // Check that t1 and t2 are both tables.
+  Record_type* r1 = get_table_type(get_type(t1));
+  if (not r1) {
+    error(t1->loc) << format("'{}' is not a list of records", pretty(t1));
+    return nullptr;
+  }
+  Record_type* r2 = get_table_type(get_type(t2));
+  if (not r2) {
+    error(t2->loc) << format("'{}' is not a list of records", pretty(t2));
+    return nullptr;
+  }
 
   //check that t3 is bool type
   Type* type_t3 = get_type(t3);
-  if (not is_same(type_t3, get_bool_type())) {
+  if (type_t3 != get_bool_type()) {
     error(t3->loc) << format("mismatched types '{0}'", 
                             pretty(type_t3));
     return nullptr;
   }
 
-  return new Join(type_t1, t1, t2, t3);
+  // The rows of the result have the members of both tables.
+  Term_seq* vars = new Term_seq();
+  vars->insert(vars->end(), r1->members()->begin(), r1->members()->end());
+  vars->insert(vars->end(), r2->members()->begin(), r2->members()->end());
+  Type* rec_type = get_record_type(vars);
+  Type* type = get_list_type(rec_type);
+
+  return new Join(t->loc, type, t1, t2, t3);
 }
 
 Expr*
@@ -979,7 +1181,7 @@ elab_union(Union_tree* t) {
   Type* type_t1 = get_type(t1);
   Type* type_t2 = get_type(t2);
 
-  if(!is_same(type_t1, type_t2))
+  if(type_t1 != type_t2)
     error(t->loc) << format("mismatched types '{0}' and '{1}'", 
                             pretty(type_t1), 
                             pretty(type_t2));
@@ -996,7 +1198,7 @@ elab_intersect(Intersect_tree* t) {
   Type* type_t1 = get_type(t1);
   Type* type_t2 = get_type(t2);
 
-  if(!is_same(type_t1, type_t2))
+  if(type_t1 != type_t2)
     error(t->loc) << format("mismatched types '{0}' and '{1}'", 
                             pretty(type_t1), 
                             pretty(type_t2));
@@ -1013,7 +1215,7 @@ elab_except(Except_tree* t) {
   Type* type_t1 = get_type(t1);
   Type* type_t2 = get_type(t2);
 
-  if(!is_same(type_t1, type_t2))
+  if(type_t1 != type_t2)
     error(t->loc) << format("mismatched types '{0}' and '{1}'", 
                             pretty(type_t1), 
                             pretty(type_t2));
@@ -1030,7 +1232,7 @@ elab_and(And_tree* t) {
   // Check that t1 has type Bool.
   Type* bool_type = get_bool_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, get_bool_type())) {
+  if (type1 != get_bool_type()) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(bool_type));
     return nullptr;
@@ -1038,7 +1240,7 @@ elab_and(And_tree* t) {
 
   //Check that t2 has type Bool
   Type* type2 = get_type(t2);
-  if (not is_same(type2, get_bool_type())) {
+  if (type2 != get_bool_type()) {
     error(t2->loc) << 
       format("term {} does not have type '{}'", typed(t2), pretty(bool_type));
     return nullptr;
@@ -1055,7 +1257,7 @@ elab_or(Or_tree* t) {
   // Check that t1 has type Bool.
   Type* bool_type = get_bool_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, get_bool_type())) {
+  if (type1 != get_bool_type()) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(bool_type));
     return nullptr;
@@ -1063,7 +1265,7 @@ elab_or(Or_tree* t) {
 
   //Check that t2 has type Bool
   Type* type2 = get_type(t2);
-  if (not is_same(type2, get_bool_type())) {
+  if (type2 != get_bool_type()) {
     error(t2->loc) << 
       format("term {} does not have type '{}'", typed(t2), pretty(bool_type));
     return nullptr;
@@ -1079,7 +1281,7 @@ elab_not(Not_tree* t) {
   // Check that t1 has type Bool.
   Type* bool_type = get_bool_type();
   Type* type1 = get_type(t1);
-  if (not is_same(type1, get_bool_type())) {
+  if (type1 != get_bool_type()) {
     error(t1->loc) << 
       format("term {} does not have type '{}'", typed(t1), pretty(bool_type));
     return nullptr;
@@ -1166,6 +1368,11 @@ elab_expr(Tree* t) {
   case union_tree: return elab_union(as<Union_tree>(t));
   case intersect_tree: return elab_intersect(as<Intersect_tree>(t));
   case except_tree: return elab_except(as<Except_tree>(t));
+  case index_tree: return elab_index(as<Index_tree>(t));
+  case group_tree: return elab_group(as<Group_tree>(t));
+  case aggregate_tree:
+    error(t->loc) << format("aggregate '{}' outside of a grouping", pretty(t));
+    return nullptr;
   case prog_tree: return elab_prog(as<Prog_tree>(t));
   default: break;
   }
@@ -0,0 +1,570 @@
+#include "env.hpp"
+#include "eval.hpp"
+#include "type.hpp"
+#include "value.hpp"
+#include "subst.hpp"
+#include "plan.hpp"
+#include "table.hpp"
+
+#include "lang/debug.hpp"
+
+#include <iostream>
+
+// -------------------------------------------------------------------------- //
+// Environments
+
+// Returns the value bound to the parameter in the given slot of the
+// function depth frames above the innermost frame of e.
+Term*
+lookup(Env* e, int depth, int slot) {
+  for (; depth != 0; --depth)
+    e = e->parent;
+  return e->values[slot];
+}
+
+namespace {
+
+// Returns the term t with the values bound in the environment e
+// substituted for the parameters they are bound to.
+Term*
+close(Term* t, Env* e) {
+  if (not e)
+    return t;
+  Subst sub;
+  for (; e; e = e->parent) {
+    if (Abs* abs = as<Abs>(e->fn)) {
+      sub.insert({abs->var(), reify(e->values[0])});
+    } else if (Fn* fn = as<Fn>(e->fn)) {
+      Term_seq* ps = fn->parms();
+      for (std::size_t i = 0; i < ps->size(); ++i)
+        sub.insert({(*ps)[i], reify(e->values[i])});
+    }
+  }
+  return subst_term(t, sub);
+}
+
+} // namespace
+
+// Returns the value v as a term of the elaborated language. A closure
+// is converted to its function, closed over its environment. A thunk
+// is converted to its value, if it has been evaluated, and to its
+// argument, closed over its environment, otherwise. Other values are
+// returned as they are.
+Term*
+reify(Term* v) {
+  if (Closure* c = as<Closure>(v))
+    return close(c->fn(), c->env());
+  if (Thunk* t = as<Thunk>(v)) {
+    if (t->value())
+      return reify(t->value());
+    return close(t->term(), t->env());
+  }
+  return v;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Evaluation
+//
+// The following functions compute the multi-step evaluation of a
+// term t in an environment E, written 'E |- t ->* v'. Tuples, records,
+// and lists are constructed from the values of their elements in E,
+// and the operands of projections and set operations are evaluated in
+// E. Selections, joins, and groupings, whose conditions name the rows
+// of their tables, are closed over their environment and evaluated by
+// their plans, as are the few remaining terms.
+
+namespace {
+
+// True when arguments are passed by need (see eval_lazy).
+bool lazy = false;
+
+Term* eval_in(Term*, Env*);
+
+// Returns the value of v. When v is a thunk, its argument is evaluated
+// the first time it is needed, and the value is kept for later uses.
+// The environment of the thunk is released once it has a value.
+Term*
+force(Term* v) {
+  if (Thunk* t = as<Thunk>(v)) {
+    if (not t->value()) {
+      t->t3 = eval_in(t->term(), t->env());
+      t->t2 = nullptr;
+    }
+    return t->value();
+  }
+  return v;
+}
+
+// Evaluate an if term.
+//
+//           E |- t1 ->* true
+//    ---------------------------------- E-if-true
+//    E |- if t1 then t2 else t3 ->* t2
+//
+//           E |- t1 ->* false
+//    ---------------------------------- E-if-false
+//    E |- if t1 then t2 else t3 ->* t3
+//
+// The selected branch is in tail position. It is returned without
+// being evaluated, and evaluated by the caller (see eval_in).
+Term*
+eval_if(If* t, Env* e) {
+  Term* bv = eval_in(t->cond(), e);
+  if (is_true(bv))
+    return t->if_true();
+  if (is_false(bv))
+    return t->if_false();
+  lang_unreachable(format("'{}' is not a boolean value", pretty(bv)));
+}
+
+// Evaluate a successor term.
+//
+//         E |- t ->* n
+//    --------------------- E-succ
+//    E |- succ t ->* n + 1
+Term*
+eval_succ(Succ* t, Env* e) {
+  Term* t1 = eval_in(t->arg(), e);
+  if (Int* n = as<Int>(t1))
+    return get_int(n->value() + Integer(1l));
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
+}
+
+// Evaluate a predecessor term.
+//
+//       E |- t ->* 0
+//    ----------------- E-pred-0
+//    E |- pred t ->* 0
+//
+//         E |- t ->* n
+//    --------------------- E-pred-succ
+//    E |- pred t ->* n - 1
+Term*
+eval_pred(Pred* t, Env* e) {
+  Term* t1 = eval_in(t->arg(), e);
+  if (Int* n = as<Int>(t1)) {
+    if (n->value() == 0)
+      return n;
+    return get_int(n->value() - Integer(1l));
+  }
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
+}
+
+// Evaluate an iszero term.
+//
+//         E |- t ->* 0
+//    ---------------------- E-iszero-0
+//    E |- iszero t ->* true
+//
+//         E |- t ->* n
+//    ----------------------- E-iszero-succ
+//    E |- iszero t ->* false
+Term*
+eval_iszero(Iszero* t, Env* e) {
+  Term* t1 = eval_in(t->arg(), e);
+  if (Int* n = as<Int>(t1))
+    return n->value() == 0 ? get_true() : get_false();
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
+}
+
+// Evaluate 't1 and t2'. Both operands are evaluated, except when
+// evaluating by need, where a false first operand decides the result.
+//
+//    E |- t1 ->* v1   E |- t2 ->* v2
+//    ------------------------------- E-and
+//    E |- t1 and t2 ->* v1 and v2
+Term*
+eval_and(And* t, Env* e) {
+  Term* t1 = eval_in(t->t1, e);
+  if (lazy and is_false(t1))
+    return get_false();
+  Term* t2 = eval_in(t->t2, e);
+  return is_true(t1) and is_true(t2) ? get_true() : get_false();
+}
+
+// Evaluate 't1 or t2'. Both operands are evaluated, except when
+// evaluating by need, where a true first operand decides the result.
+//
+//    E |- t1 ->* v1   E |- t2 ->* v2
+//    ------------------------------- E-or
+//    E |- t1 or t2 ->* v1 or v2
+Term*
+eval_or(Or* t, Env* e) {
+  Term* t1 = eval_in(t->t1, e);
+  if (lazy and is_true(t1))
+    return get_true();
+  Term* t2 = eval_in(t->t2, e);
+  return is_false(t1) and is_false(t2) ? get_false() : get_true();
+}
+
+// Evaluate 'not t1'.
+//
+//        E |- t1 ->* true
+//    ------------------------ E-not-true
+//    E |- not t1 ->* false
+//
+//        E |- t1 ->* false
+//    ------------------------ E-not-false
+//    E |- not t1 ->* true
+Term*
+eval_not(Not* t, Env* e) {
+  Term* t1 = eval_in(t->t1, e);
+  if (is_true(t1))
+    return get_false();
+  if (is_false(t1))
+    return get_true();
+  lang_unreachable(format("'{}' is not a boolean value", pretty(t1)));
+}
+
+// Evaluate 't1 eq t2'.
+Term*
+eval_equals(Equals* t, Env* e) {
+  Term* t1 = eval_in(t->t1, e);
+  Term* t2 = eval_in(t->t2, e);
+  return is_same(t1, t2) ? get_true() : get_false();
+}
+
+// Evaluate 't1 lt t2'.
+Term*
+eval_less(Less* t, Env* e) {
+  Term* t1 = eval_in(t->t1, e);
+  Term* t2 = eval_in(t->t2, e);
+  return is_less(t1, t2) ? get_true() : get_false();
+}
+
+// Evaluate a function, producing a closure.
+//
+//    ------------------------- E-abs
+//    E |- \x:T.t ->* <\x:T.t, E>
+//
+// A function evaluated outside of any other function is closed, so it
+// is its own closure.
+Term*
+eval_fn(Term* t, Env* e) {
+  if (not e)
+    return t;
+  return new Closure(t->loc, get_type(t), t, e);
+}
+
+// Returns the function of the closure c, and sets e to its
+// environment. A function that is not in a closure has an empty
+// environment.
+Term*
+get_function(Term* c, Env*& e) {
+  if (Closure* c0 = as<Closure>(c)) {
+    e = c0->env();
+    return c0->fn();
+  }
+  e = nullptr;
+  return c;
+}
+
+// Returns the argument t, evaluated in the environment e, to be bound
+// to a parameter. When evaluating by need, the argument is deferred in
+// a thunk instead. Arguments that are already values, functions, and
+// other parameters need no thunk of their own; a parameter passes the
+// thunk it is bound to, so the argument is evaluated at most once.
+Term*
+eval_arg(Term* t, Env* e) {
+  if (not lazy)
+    return eval_in(t, e);
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case table_term:
+  case abs_term:
+  case fn_term:
+    return eval_in(t, e);
+  case ref_term: {
+    Ref* r = as<Ref>(t);
+    if (r->depth >= 0)
+      return lookup(e, r->depth, r->slot);
+    return eval_in(t, e);
+  }
+  default:
+    return new Thunk(t->loc, get_type(t), t, e);
+  }
+}
+
+// Evaluate an application.
+//
+//    E |- t1 ->* <\x:T.t, E'>   E |- t2 ->* v   E', x=v |- t ->* v'
+//    -------------------------------------------------------------- E-app
+//                         E |- t1 t2 ->* v'
+//
+// The body of the function is in tail position. It is returned, and e
+// is set to the environment in which the caller evaluates it.
+Term*
+eval_app(App* t, Env*& e) {
+  Env* outer;
+  Abs* fn = as<Abs>(get_function(eval_in(t->abs(), e), outer));
+  lang_assert(fn, format("ill-formed application target '{}'", pretty(t->abs())));
+
+  Env* inner = new_in_arena<Env>(fn, outer);
+  inner->values.push_back(eval_arg(t->arg(), e));
+  e = inner;
+  return fn->term();
+}
+
+// Evaluate a function call. Arguments are evaluated in turn. Unlike
+// the substitution rules, the arguments of the call are not replaced.
+//
+//    E |- t ->* <\(x1:T1, ..., xn:Tn).t', E'>
+//    for each i E |- ti ->* vi
+//    E', x1=v1, ..., xn=vn |- t' ->* v
+//    ---------------------------------------- E-call
+//    E |- t(t1, ..., tn) ->* v
+//
+// As with application, the body is evaluated by the caller.
+Term*
+eval_call(Call* t, Env*& e) {
+  Env* outer;
+  Fn* fn = as<Fn>(get_function(eval_in(t->fn(), e), outer));
+  lang_assert(fn, format("ill-formed call target '{}'", pretty(t->fn())));
+
+  Env* inner = new_in_arena<Env>(fn, outer);
+  inner->values.reserve(t->args()->size());
+  for (Term* a : *t->args())
+    inner->values.push_back(eval_arg(a, e));
+  e = inner;
+  return fn->term();
+}
+
+// Evaluate a reference. A reference to a parameter is replaced by the
+// value bound in the environment, which is found by the depth and slot
+// of the reference. A reference to a definition is replaced by the
+// definition's value.
+//
+//    x=v in E
+//    ------------ E-ref-var
+//    E |- x ->* v
+//
+// As with the substitution rules, a reference to a type definition
+// has no value. A parameter bound to a thunk is evaluated here, when
+// it is first needed.
+Term*
+eval_ref(Ref* t, Env* e) {
+  if (t->depth >= 0)
+    return force(lookup(e, t->depth, t->slot));
+  if (Def* def = as<Def>(t->decl()))
+    return as<Term>(def->value());
+  return t;
+}
+
+// Evaluate a definition. The defined value replaces the initializer
+// of the definition, as for the substitution rules.
+Term*
+eval_def(Def* t, Env* e) {
+  if (Term* t0 = as<Term>(t->value()))
+    t->t2 = reify(eval_in(t0, e));
+  return t;
+}
+
+// Evaluate each term in the sequence ts in the environment e. The
+// values are reified, so that the elements of a tuple or list do not
+// refer to the environment.
+Term_seq*
+eval_seq(Term_seq* ts, Env* e) {
+  Term_seq* vs = new Term_seq();
+  vs->reserve(ts->size());
+  for (Term* t : *ts)
+    vs->push_back(reify(eval_in(t, e)));
+  return vs;
+}
+
+// Evaluate a tuple.
+//
+//       for each i E |- ti ->* vi
+//    ------------------------------------ E-tuple
+//    E |- {t1, ..., tn} ->* {v1, ..., vn}
+//
+// A value with no abstractions is returned as it is; the abstractions
+// of other values may refer to e, and are closed over it. The result
+// is marked as a value. The same holds for records and lists.
+Term*
+eval_tuple(Tuple* t, Env* e) {
+  if (is_ground_value(t))
+    return t;
+  Tuple* v = new Tuple(t->loc, get_type(t), eval_seq(t->elems(), e));
+  v->normal = true;
+  return v;
+}
+
+// Evaluate a record.
+//
+//               for each i E |- ti ->* vi
+//    ---------------------------------------------------- E-record
+//    E |- {n1=t1, ..., nn=tn} ->* {n1=v1, ..., nn=vn}
+Term*
+eval_record(Record* t, Env* e) {
+  if (is_ground_value(t))
+    return t;
+  Term_seq* ms = new Term_seq();
+  ms->reserve(t->members()->size());
+  for (Term* m : *t->members()) {
+    Init* i = as<Init>(m);
+    Term* v = reify(eval_in(as<Term>(i->value()), e));
+    ms->push_back(new Init(i->loc, get_type(i), i->name(), v));
+  }
+  Record* v = new Record(t->loc, get_type(t), ms);
+  v->normal = true;
+  return v;
+}
+
+// Evaluate a list.
+//
+//       for each i E |- ti ->* vi
+//    ------------------------------------ E-list
+//    E |- [t1, ..., tn] ->* [v1, ..., vn]
+//
+// A list of records is stored as a table, which is built from the
+// values of its records by the substitution rules.
+Term*
+eval_list(List* t, Env* e) {
+  if (is_ground_value(t))
+    return is_table_type(get_type(t)) ? eval(t) : t;
+  List* v = new List(t->loc, get_type(t), eval_seq(t->elems(), e));
+  v->normal = true;
+  return is_table_type(get_type(t)) ? eval(v) : v;
+}
+
+// Evaluate a member or element projection. The projected term is
+// evaluated in e, and the member or element is found in its value by
+// the substitution rules.
+//
+//    E |- t ->* v   v.n ->* v'
+//    ------------------------- E-mem
+//         E |- t.n ->* v'
+template<typename T>
+  Term*
+  eval_member(T* t, Env* e) {
+    Term* v = eval_in(t->t1, e);
+    return eval(new T(t->loc, get_type(t), v, t->t2));
+  }
+
+// Returns the union, intersection, or difference t of the values of
+// its operands in e. The set operation on those values is computed by
+// the substitution rules, or by its plan when they are tables.
+//
+//    E |- t1 ->* v1   E |- t2 ->* v2   v1 op v2 ->* v
+//    ------------------------------------------------ E-set
+//              E |- t1 op t2 ->* v
+template<typename T>
+  Term*
+  make_set(T* t, Env* e) {
+    Term* v1 = eval_in(t->t1, e);
+    Term* v2 = eval_in(t->t2, e);
+    return new T(t->loc, get_type(t), v1, v2);
+  }
+
+// Evaluate a print statement. The rows of a query are printed by the
+// substitution rules, as they are produced. A set operation on tables
+// is printed from the values of its operands.
+Term*
+eval_print(Print* t, Env* e) {
+  Term* term = as<Term>(t->expr());
+  if (term and is_query(term)) {
+    switch (term->kind) {
+    case union_term: term = make_set(as<Union>(term), e); break;
+    case intersect_term: term = make_set(as<Intersect>(term), e); break;
+    case except_term: term = make_set(as<Except>(term), e); break;
+    default: term = close(term, e); break;
+    }
+    return ::eval_print(new Print(t->loc, get_type(t), term), std::cout);
+  }
+
+  Term* val = term ? eval_in(term, e) : nullptr;
+  if (val)
+    std::cout << pretty(reify(val)) << '\n';
+  else
+    std::cout << pretty(t->expr()) << '\n';
+  return get_unit();
+}
+
+// Evaluate each statement in turn. The last statement is in tail
+// position, and is evaluated by the caller.
+Term*
+eval_prog(Prog* t, Env* e) {
+  Term_seq* ss = t->stmts();
+  if (ss->empty())
+    return get_unit();
+  for (std::size_t i = 0; i + 1 < ss->size(); ++i)
+    eval_in((*ss)[i], e);
+  return ss->back();
+}
+
+// Compute the multi-step evaluation of the term t in the
+// environment e. As in eval, terms in tail position are evaluated
+// by iteration, so a chain of tail calls runs in constant native
+// stack.
+Term*
+eval_in(Term* t, Env* e) {
+  for (;;) {
+    switch (t->kind) {
+    case if_term: t = eval_if(as<If>(t), e); continue;
+    case app_term: t = eval_app(as<App>(t), e); continue;
+    case call_term: t = eval_call(as<Call>(t), e); continue;
+    case prog_term: t = eval_prog(as<Prog>(t), e); continue;
+    case and_term: return eval_and(as<And>(t), e);
+    case or_term: return eval_or(as<Or>(t), e);
+    case not_term: return eval_not(as<Not>(t), e);
+    case equals_term: return eval_equals(as<Equals>(t), e);
+    case less_term: return eval_less(as<Less>(t), e);
+    case succ_term: return eval_succ(as<Succ>(t), e);
+    case pred_term: return eval_pred(as<Pred>(t), e);
+    case iszero_term: return eval_iszero(as<Iszero>(t), e);
+    case abs_term: return eval_fn(t, e);
+    case fn_term: return eval_fn(t, e);
+    case ref_term: return eval_ref(as<Ref>(t), e);
+    case def_term: return eval_def(as<Def>(t), e);
+    case print_term: return eval_print(as<Print>(t), e);
+    case comma_term: return get_unit();
+    case tuple_term: return eval_tuple(as<Tuple>(t), e);
+    case record_term: return eval_record(as<Record>(t), e);
+    case list_term: return eval_list(as<List>(t), e);
+    case proj_term: return eval_member(as<Proj>(t), e);
+    case mem_term: return eval_member(as<Mem>(t), e);
+    case union_term: return eval(make_set(as<Union>(t), e));
+    case intersect_term: return eval(make_set(as<Intersect>(t), e));
+    case except_term: return eval(make_set(as<Except>(t), e));
+    case unit_term:
+    case true_term:
+    case false_term:
+    case int_term:
+    case str_term:
+    case table_term:
+    case closure_term: return t;
+    default: break;
+    }
+    return eval(close(t, e));
+  }
+}
+
+} // namespace
+
+// Compute the multi-step evaluation of the term t using environments
+// rather than substitution. Function values in the result are
+// converted to terms.
+Term*
+eval_env(Term* t) {
+  return reify(eval_in(t, nullptr));
+}
+
+// Compute the multi-step evaluation of the term t in environments,
+// passing arguments by need. Each argument is deferred in a thunk
+// that is evaluated the first time its parameter is referenced, and
+// is shared by every later reference. An argument that is never
+// referenced is never evaluated. The operators 'and' and 'or' do not
+// evaluate their second operand when the first decides the result.
+Term*
+eval_lazy(Term* t) {
+  bool outer = lazy;
+  lazy = true;
+  Term* r = reify(eval_in(t, nullptr));
+  lazy = outer;
+  return r;
+}
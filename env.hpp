@@ -0,0 +1,41 @@
+
+#ifndef ENV_HPP
+#define ENV_HPP
+
+#include "ast.hpp"
+
+#include <vector>
+
+// This module defines an environment-based evaluator. Unlike the
+// substitution-based evaluator (see eval.hpp), the body of a function
+// is never copied when it is called. Instead, terms are evaluated in
+// an environment binding the parameters of the enclosing functions
+// to their arguments, and function values are closures. The
+// elaborated program is not modified, except for the values of
+// definitions.
+
+// -------------------------------------------------------------------------- //
+// Environments
+
+// A frame of an environment, binding the parameters of a function
+// (an abstraction or a multi-parameter function) to the values of
+// its arguments, in order. When arguments are passed by need, a
+// value may be a thunk (see eval_lazy). Each frame is linked to the
+// environment of the closure that was called. Frames are allocated
+// in the current arena (see new_in_arena).
+struct Env {
+  Env(Term* f, Env* p)
+    : fn(f), parent(p) { }
+
+  Term* fn;
+  std::vector<Term*> values;
+  Env* parent;
+};
+
+Term* lookup(Env*, int, int);
+Term* reify(Term*);
+
+Term* eval_env(Term*);
+Term* eval_lazy(Term*);
+
+#endif
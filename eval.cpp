@@ -5,18 +5,74 @@
 #include "type.hpp"
 #include "value.hpp"
 #include "subst.hpp"
+#include "table.hpp"
+#include "filter.hpp"
+#include "plan.hpp"
+#include "group.hpp"
+#include "env.hpp"
+#include "vm.hpp"
+#include "memo.hpp"
+#include "par.hpp"
 
 #include "lang/debug.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // -------------------------------------------------------------------------- //
 // Evaluator class
 
+namespace {
+
+// The table of memoized calls, or nullptr when calls are not memoized.
+Memo_table* memo_table = nullptr;
+
+// The number of print statements evaluated so far. A call that prints
+// is not memoized. Statements may be evaluated by several threads
+// (see par.hpp).
+std::atomic<std::size_t> print_count {0};
+
+// The stream to which print statements evaluated on this thread write
+// their output (see set_output).
+thread_local std::ostream* output = &std::cout;
+
+// A helper class that installs a memo table of the given capacity for
+// the lifetime of an evaluation. A capacity of 0 installs no table.
+struct Memo_guard {
+  Memo_guard(std::size_t n)
+    : table(n), outer(memo_table) {
+    if (n)
+      memo_table = &table;
+  }
+  ~Memo_guard() { memo_table = outer; }
+
+  Memo_table table;
+  Memo_table* outer;
+};
+
+} // namespace
+
 Term*
 Evaluator::operator()(Term* t) {
-  return eval(t);
+  Arena_guard arena_guard(&arena);
+  Memo_guard guard(threads > 1 ? 0 : memo);
+  switch (mode) {
+  case subst_eval: return threads > 1 ? eval_parallel(t, threads) : eval(t);
+  case env_eval: return eval_env(t);
+  case vm_eval: return eval_vm(t);
+  case lazy_eval: return eval_lazy(t);
+  case step_eval: {
+    Step_result r = step(t, fuel);
+    suspended = not r.done;
+    return r.term;
+  }
+  }
+  lang_unreachable("unknown evaluation mode");
 }
 
 
@@ -41,13 +97,16 @@ namespace {
 //             t1 ->* true
 //    ---------------------------- E-if-false
 //    if t1 then t2 else t3 ->* t2
+//
+// The selected branch is in tail position. It is returned without
+// being evaluated, and evaluated by the caller (see eval).
 Term*
 eval_if(If* t) {
   Term* bv = eval(t->cond());
   if (is_true(bv))
-    return eval(t->if_true());
+    return t->if_true();
   if (is_false(bv))
-    return eval(t->if_false());
+    return t->if_false();
   lang_unreachable(format("'{}' is not a boolean value", pretty(bv)));
 }
 
@@ -63,7 +122,7 @@ eval_succ(Succ* t) {
   Term* t1 = eval(t->arg());
   if (Int* n = as<Int>(t1)) {
     const Integer& z = n->value();
-    return new Int(t->loc, get_type(t), z + 1);
+    return get_int(z + Integer(1l));
   }
   lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
 }
@@ -87,7 +146,7 @@ eval_pred(Pred* t) {
     if (z == 0)
       return n;
     else
-      return new Int(t->loc, get_type(t), z - 1);
+      return get_int(z - Integer(1l));
   }
   lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
 }
@@ -107,13 +166,38 @@ eval_iszero(Iszero* t) {
   if (Int* n = as<Int>(t1)) {
     const Integer& z = n->value();
     if (z == 0)
-      return new True(t->loc, get_bool_type());
+      return get_true();
     else
-      return new False(t->loc, get_bool_type());
+      return get_false();
   }
   lang_unreachable(format("'{}' is not a numeric value", pretty(t1)));
 }
 
+// Returns the value of the call of the function fn with the argument
+// values in args, when calls are memoized. The value is found in the
+// memo table before the body of the function is reduced. Otherwise,
+// the body is reduced by reduce(), evaluated, and its value is added
+// to the table unless the call printed. Calls taking values that
+// cannot be hashed (e.g., functions) are not memoized; their reduced
+// body is returned, to be evaluated by the caller in tail position.
+//
+// Note that a memoized call is not evaluated in tail position.
+template<typename F>
+  Term*
+  eval_body(Term* fn, const std::vector<Term*>& args, F reduce) {
+    for (Term* a : args)
+      if (not is_memo_arg(a))
+        return reduce();
+    Memo_key k {fn, args};
+    if (Term* v = memo_table->find(k))
+      return v;
+    std::size_t n = print_count;
+    Term* v = eval(reduce());
+    if (print_count == n)
+      memo_table->insert(k, v);
+    return v;
+  }
+
 // Evaluate an application.
 //
 //        t1 ->* \x:T.t
@@ -123,6 +207,9 @@ eval_iszero(Iszero* t) {
 //          t2 ->* v
 //    --------------------- E-app-2
 //    \x:T.t t2 ->* [x->v]t
+//
+// The result of the beta reduction is in tail position, and is
+// evaluated by the caller (see eval_body).
 Term*
 eval_app(App* t) {
   Abs* fn = as<Abs>(eval(t->abs())); // E-app-1
@@ -130,14 +217,19 @@ eval_app(App* t) {
 
   Term* arg = eval(t->arg()); // E-app-2
     
-  // Perform a beta reduction and evaluate the result.
-  Subst sub {fn->var(), arg};
-  Term* res = subst_term(fn->term(), sub);
-  return eval(res);
+  // Perform a beta reduction.
+  auto reduce = [fn, arg]() -> Term* {
+    Subst sub {fn->var(), arg};
+    return subst_term(fn->term(), sub);
+  };
+  if (memo_table)
+    return eval_body(fn, {arg}, reduce);
+  return reduce();
 }
 
 // Evaluate a function call. This is virtually identical to
 // application except that all arguments are evaluated in turn.
+// As with application, the reduced term is evaluated by the caller.
 //
 // TODO: Document the semantics of these operations.
 Term*
@@ -146,17 +238,21 @@ eval_call(Call* t) {
   Fn* fn = as<Fn>(eval(t->fn()));
   lang_assert(fn, format("ill-formed call target '{}'", pretty(t->fn())));
 
-  // Evaluate arguments in place. That is, we're not creating
-  // a new sequence of arguments, just replacing the entries
-  // in the existing sequence.
-  Term_seq* args = t->args();
-  for (Term*& a : *args)
-    a = eval(a);
-
-  // Beta reduce and evaluate.
-  Subst sub {fn->parms(), args};
-  Term* result = subst_term(fn->term(), sub);
-  return eval(result);
+  // Evaluate the arguments into a new sequence. The arguments of the
+  // call are not replaced, since the call may be evaluated again.
+  Term_seq* args = new Term_seq();
+  args->reserve(t->args()->size());
+  for (Term* a : *t->args())
+    args->push_back(eval(a));
+
+  // Beta reduce.
+  auto reduce = [fn, args]() -> Term* {
+    Subst sub {fn->parms(), args};
+    return subst_term(fn->term(), sub);
+  };
+  if (memo_table)
+    return eval_body(fn, {args->begin(), args->end()}, reduce);
+  return reduce();
 }
 
 // Elaborate a declaration reference. When the reference
@@ -196,6 +292,9 @@ eval_def(Def* t) {
   return t;
 }
 
+Term* eval_query(Term*);
+void print_query(std::ostream&, Term*);
+
 // Elaborate a print statement.
 //
 //          t ->* v
@@ -208,21 +307,49 @@ eval_def(Def* t) {
 //    --------------- E-print-type
 //    print T -> unit
 //
+// The output is written to os.
+} // namespace
+
+// Sets the stream to which print statements evaluated on the calling
+// thread write their output, and returns the previous stream.
+std::ostream*
+set_output(std::ostream* os) {
+  std::ostream* prev = output;
+  output = os;
+  return prev;
+}
+
 Term*
-eval_print(Print* t) {
-  // Try to evaluate the expression.
+eval_print(Print* t, std::ostream& os) {
+  ++print_count;
+
+  // Try to evaluate the expression. The rows of a query are printed
+  // as they are produced.
   Term* val = nullptr;
-  if (Term* term = as<Term>(t->expr()))
+  if (Term* term = as<Term>(t->expr())) {
+    if (is_query(term)) {
+      print_query(os, term);
+      os << '\n';
+      return get_unit();
+    }
     val = eval(term);
+  }
 
   // Print the result, or if the expression is not
   // evaluable, just print the expression.
   if (val)
-    std::cout << pretty(val) << '\n';
+    os << pretty(val) << '\n';
   else
-    std::cout << pretty(t->expr()) << '\n';
+    os << pretty(t->expr()) << '\n';
 
-  return new Unit(t->loc, get_unit_type());
+  return get_unit();
+}
+
+namespace {
+
+Term*
+eval_print(Print* t) {
+  return ::eval_print(t, *output);
 }
 
 // FIXME: Actually evaluate each expression in turn.
@@ -237,12 +364,17 @@ eval_comma(Comma* t) {
 //    for each i ei ->* vi
 //    -------------------- E-prog
 //     e1; ...; en ->* vn
+//
+// The last statement is in tail position, and is evaluated by the
+// caller.
 Term*
 eval_prog(Prog* t) {
-  Term* tn;
-  for (Term* ti : *t->stmts())
-    tn = eval(ti);
-  return tn;
+  Term_seq* ss = t->stmts();
+  if (ss->empty())
+    return get_unit();
+  for (std::size_t i = 0; i + 1 < ss->size(); ++i)
+    eval((*ss)[i]);
+  return ss->back();
 }
 
 // Evaluation for 't1 and t2'
@@ -352,6 +484,99 @@ eval_less(Less* t) {
     return get_false();
 }
 
+// Evaluate each term in the sequence ts.
+Term_seq*
+eval_seq(Term_seq* ts) {
+  Term_seq* vs = new Term_seq();
+  vs->reserve(ts->size());
+  for (Term* t : *ts)
+    vs->push_back(eval(t));
+  return vs;
+}
+
+// Evaluate each element of the list t. The elements of a list value
+// are returned as they are.
+Term_seq*
+eval_elems(List* t) {
+  if (is_list_value(t))
+    return t->elems();
+  return eval_seq(t->elems());
+}
+
+// Add the members of the record value r as a new row of the table t.
+void
+eval_row(Table* t, Record* r) {
+  Term_seq* ms = r->members();
+  for (std::size_t i = 0; i < ms->size(); ++i)
+    t->column(i)->push_back(as<Term>(as<Init>((*ms)[i])->value()));
+}
+
+// Evaluate a tuple.
+//
+//         for each i ti ->* vi
+//    ------------------------------- E-tuple
+//    {t1, ..., tn} ->* {v1, ..., vn}
+//
+// A tuple value is returned as it is, and the result of evaluation is
+// marked as a value. The same holds for records and lists.
+Term*
+eval_tuple(Tuple* t) {
+  if (is_tuple_value(t))
+    return t;
+  Tuple* v = new Tuple(t->loc, get_type(t), eval_seq(t->elems()));
+  v->normal = true;
+  return v;
+}
+
+// Evaluate a record.
+//
+//                for each i ti ->* vi
+//    ----------------------------------------------- E-record
+//    {n1=t1, ..., nn=tn} ->* {n1=v1, ..., nn=vn}
+Term*
+eval_record(Record* t) {
+  if (is_record_value(t))
+    return t;
+  Term_seq* ms = new Term_seq();
+  ms->reserve(t->members()->size());
+  for (Term* m : *t->members()) {
+    Init* i = as<Init>(m);
+    Term* v = eval(as<Term>(i->value()));
+    ms->push_back(new Init(i->loc, get_type(i), i->name(), v));
+  }
+  Record* v = new Record(t->loc, get_type(t), ms);
+  v->normal = true;
+  return v;
+}
+
+// Evaluation of a list of records.
+//
+//    for each i ri ->* {l1=vi1, ..., lk=vik}
+//    ------------------------------------------------ E-table
+//    [r1, ..., rn] ->* [l1=[v11, ..., vn1], ..., lk=[v1k, ..., vnk]]
+//
+// The resulting table stores the members of the records by column.
+// The elements of other lists are evaluated in turn.
+//
+//       for each i ti ->* vi
+//    ----------------------------- E-list
+//    [t1, ..., tn] ->* [v1, ..., vn]
+Term*
+eval_list(List* t) {
+  Type* type = get_type(t);
+  if (not is_table_type(type)) {
+    if (is_list_value(t))
+      return t;
+    List* v = new List(t->loc, type, eval_seq(t->elems()));
+    v->normal = true;
+    return v;
+  }
+  Table* table = make_table(type, t->elems()->size());
+  for (Term* e : *t->elems())
+    eval_row(table, as<Record>(eval(e)));
+  return table;
+}
+
 ///////////////////////////////////
 //
 // Evaluation for Relational Algebra
@@ -363,32 +588,18 @@ eval_proj(Proj* t) {
   return nullptr;
 }
 
-// Returns a column projection for tables
+// Returns a column projection for tables. The column is shared
+// with the table; no values are copied.
 Term*
 eval_col(Mem* t) {
-  List* table = as<List>(eval(t->t1));
+  Table* table = as<Table>(eval(t->t1));
   Ref* member = as<Ref>(t->member());
   Var* v = as<Var>(member->decl());
-  Name* n = v->name();
 
-  Term_seq* records = table->elems();
-  Term_seq* vars = new Term_seq();
-  vars->push_back(v);
-  Type* rec_type = new Record_type(get_kind_type(), vars);
-
-  // resulting column
-  Term_seq* col = new Term_seq();
-  for (auto r : *records) {
-    for (auto i : *as<Record>(r)->members()) {
-      if (is_same(n, as<Init>(i)->name())) {
-        Term_seq* e = new Term_seq();
-        e->push_back(i);
-        col->push_back(new Record(rec_type, e));
-      }
-    }
-  }
-  Type* type = new List_type(get_kind_type(), rec_type);
-  return new List(type, col);
+  Term_seq* vars = new Term_seq {v};
+  Type* rec_type = get_record_type(vars);
+  Type* type = get_list_type(rec_type);
+  return project_table(table, type, {find_column(table, v->name())});
 }
 
 // Returns a term from the record such that the label in the record matches l
@@ -418,262 +629,1642 @@ eval_mem(Mem* t) {
   return nullptr;
 }
 
-// Merges records a and b
-Record*
-merge_records(Record* a, Record* b) {
-  Term_seq* a_mem = a->members();
-  Term_seq* b_mem = b->members();
-  Term_seq* elems = new Term_seq();
-
-  elems->insert(elems->end(), a_mem->begin(), a_mem->end());
-  elems->insert(elems->end(), b_mem->begin(), b_mem->end());
-  
-  Record_type* ar_type = as<Record_type>(get_type(a));
-  Record_type* br_type = as<Record_type>(get_type(b));
+// Evaluation for 'select t1 from t2 where t3'
+//
+//    t2 ->* [r1, ..., rn]
+//    ------------------------------------------------------------ E-select
+//    select t1 from t2 where t3 ->* [t1(ri) | [t2->ri]t3 ->* true]
+//
+// The query is evaluated by its plan. The condition is compiled into
+// a filter over the columns of the table, which selects the rows
+// satisfying it. Only the projected columns of the selected rows are
+// copied to the result.
+Term*
+eval_select_from_where(Select_from_where* t) {
+  return eval_query(t);
+}
 
-  Term_seq* vars = new Term_seq();
-  vars->insert(vars->end(), ar_type->members()->begin(), ar_type->members()->end());
-  vars->insert(vars->end(), br_type->members()->begin(), br_type->members()->end());
+// If t has the form 'd.k' where 'd.k' is a column of the schema s and
+// 'd' names no column of the schema o, returns the index of that
+// column in s. Otherwise, returns -1.
+std::size_t
+get_join_key(Term* t, const Plan_schema& s, const Plan_schema& o) {
+  Mem* m = as<Mem>(t);
+  if (not m)
+    return -1;
+  Ref* table = as<Ref>(m->record());
+  Ref* member = as<Ref>(m->member());
+  if (not table or not member)
+    return -1;
+  Var* v = as<Var>(member->decl());
+  if (not v)
+    return -1;
+  for (const Plan_column& c : o)
+    if (c.def == table->decl())
+      return -1;
+  for (std::size_t i = 0; i < s.size(); ++i)
+    if (s[i].def == table->decl() and is_same(s[i].var->name(), v->name()))
+      return i;
+  return -1;
+}
 
-  Record_type* type = new Record_type(get_kind_type(), vars);
-  return new Record(type, elems);
+// The keys of an equi-join condition 'a.k1 eq b.k2', where 'a.k1' and
+// 'b.k2' are columns of the left and right inputs of the join. Keys
+// are the indexes of those columns.
+struct Join_key {
+  std::size_t left;
+  std::size_t right;
+};
+
+// Search the condition c for an equality predicate between a column
+// of the left input a and a column of the right input b. The predicate
+// may be the entire condition or any operand of a conjunction.
+bool
+find_join_key(Term* c, const Plan_schema& a, const Plan_schema& b, Join_key& key) {
+  if (Equals* e = as<Equals>(c)) {
+    std::size_t l = get_join_key(e->t1, a, b);
+    std::size_t r = get_join_key(e->t2, b, a);
+    if (l != std::size_t(-1) and r != std::size_t(-1)) {
+      key = {l, r};
+      return true;
+    }
+    l = get_join_key(e->t2, a, b);
+    r = get_join_key(e->t1, b, a);
+    if (l != std::size_t(-1) and r != std::size_t(-1)) {
+      key = {l, r};
+      return true;
+    }
+    return false;
+  }
+  if (And* t = as<And>(c))
+    return find_join_key(t->t1, a, b, key) or find_join_key(t->t2, a, b, key);
+  return false;
 }
 
-// Appends table b to the rhs of table a
-// a and b must be a list of Records to work
-// else bad things happen
-List*
-merge_tables(List* a, List* b) {
-  // assume the record type because these are supposed to be tables
-  List_type* al_type = as<List_type>(get_type(a));
-  List_type* bl_type = as<List_type>(get_type(b));
-  Record_type* ar_type = as<Record_type>(al_type->type());
-  Record_type* br_type = as<Record_type>(bl_type->type());
+// The rows of the left and right tables of a join that are paired
+// in its result.
+struct Join_rows {
+  std::vector<std::size_t> left;
+  std::vector<std::size_t> right;
+};
+
+// Join the rows of t1 and t2 by comparing every pair of rows. This
+// is used only when the join condition has no equality predicate.
+void
+nested_loop_join(const Filter& cond, Table* t1, Table* t2, Join_rows& rows) {
+  std::size_t pair[2];
+  for (pair[0] = 0; pair[0] < t1->rows(); ++pair[0]) {
+    for (pair[1] = 0; pair[1] < t2->rows(); ++pair[1]) {
+      if (cond.test(pair)) {
+        rows.left.push_back(pair[0]);
+        rows.right.push_back(pair[1]);
+      }
+    }
+  }
+}
 
-  Term_seq* vars = new Term_seq();
-  vars->insert(vars->end(), ar_type->members()->begin(), ar_type->members()->end());
-  vars->insert(vars->end(), br_type->members()->begin(), br_type->members()->end());
-  Record_type* nr_type = new Record_type(get_kind_type(), vars);
+// The rows of a table partitioned by the hash of their key column.
+using Join_index = std::unordered_map<std::size_t, std::vector<std::size_t>>;
+
+// Returns the index of the rows of a table on its key column c.
+Join_index
+make_join_index(const Column& c) {
+  Join_index index;
+  index.reserve(c.size());
+  for (std::size_t j = 0; j < c.size(); ++j)
+    index[hash(c, j)].push_back(j);
+  return index;
+}
 
-  //merge the individual records in the table
-  Term_seq* rec = new Term_seq();
-  auto it_a = a->elems()->begin();
-  auto it_b = b->elems()->begin();
-  while (it_a != a->elems()->end()) {
-    rec->push_back(merge_records(as<Record>(*it_a), as<Record>(*it_b)));
-    ++it_a;
-    ++it_b;
+// Join the rows of t1 and t2 on the equality of the given keys. The
+// rows of t2 are partitioned by the hash of their key column (build),
+// and each row of t1 looks up the rows with the same key (probe).
+// When the condition has other predicates than the key, they are
+// tested for each pair of rows that agree on the key.
+//
+// Rows are produced in the same order as a nested loop join.
+void
+hash_join(const Filter& cond, Table* t1, Table* t2, const Join_key& key,
+          const Join_index& index, Join_rows& rows) {
+  const Column& c1 = *t1->column(key.left);
+  const Column& c2 = *t2->column(key.right);
+
+  bool residual = cond.nodes[cond.root].op != Filter::eq_op;
+  std::size_t pair[2];
+  for (pair[0] = 0; pair[0] < t1->rows(); ++pair[0]) {
+    auto iter = index.find(hash(c1, pair[0]));
+    if (iter == index.end())
+      continue;
+    for (std::size_t j : iter->second) {
+      pair[1] = j;
+      if (not is_same(c1, pair[0], c2, j))
+        continue;
+      if (residual and not cond.test(pair))
+        continue;
+      rows.left.push_back(pair[0]);
+      rows.right.push_back(j);
+    }
   }
-
-  List_type* l_type = new List_type(get_kind_type(), nr_type);
-  List* res = new List(l_type, rec);
-  return res;
 }
 
-//evaluation for select t1 from t2 where t3
-Term*
-eval_select_from_where(Select_from_where* t) {
-  //evaluate the list first
-  List* t2 = as<List>(eval(t->t2));
-
-  //new term seq to hold var list for record type
-  Term_seq* cols = new Term_seq();
-  //if its more than one projection operator
-  if (Comma* c = as<Comma>(t->t1)) {
-    for (auto p : *c->elems()) {
-      Mem* m = as<Mem>(p);
-      List* col = as<List>(eval(m));
-      cols->push_back(col);
-    }
-  }
-
-  //in case its just one projection
-  if (Mem* m = as<Mem>(t->t1)) {
-    cols->push_back(eval(m));
-  }
-
-  //construct the new table after projection
-  List* n_table = as<List>(*cols->begin());
-  if(cols->size() > 1) {
-    auto it1 = cols->begin() + 1;
-    while (it1 != cols->end()) {
-      n_table = merge_tables(n_table, as<List>(*it1));
-      ++it1;
-    }
-  }
-
-  // t2 should be a Def or a Ref
-  // we cannot have a table with no name here
-  Term* subst;
-  if (Ref* ref = as<Ref>(t->t2))
-    subst = eval(as<Def>(ref->decl()));
-  if (Def* def = as<Def>(t->t2))
-    subst = eval(def);
-
-  // first we need to produce a set of conditions
-  // t3 is not just 1 condition, it is a condition for every record in the list
-  // for each record in t2, we need to substitute the ref t2 in t3 with that record
-  // this gives us a list of conditions which we can evaluate
-  Term_seq* records = t2->elems();
-  Term_seq* conds = new Term_seq();
-  for(auto r : *records) {
-    Subst sub { subst, r };
-    Term* res = subst_term(t->cond(), sub);
-    conds->push_back(res);
-  }
-
-  // iterate through the table's records and the conditions
-  // if the condition evaluates to true then add the record to result
-  auto cond_it = conds->begin();
-  auto table_it = n_table->elems()->begin();
-  if(conds->size() == n_table->elems()->size()) {
-    Term_seq* sel_rec = new Term_seq();
-    // true
-    Term* _true = get_true();
-    while(cond_it != conds->end()) {
-      //check if the evaluation of the condition is true
-      if(is_same(_true, eval(*cond_it))) {
-        sel_rec->push_back(*table_it);
+// Join the rows of t1 and t2 on the equality of the given keys by
+// sorting the rows of t1 on their keys and then merging them with the
+// rows of t2 in the sorted order s2. Tables that are already sorted on
+// their keys are not sorted again. When the condition has other
+// predicates than the key, they are tested for each pair of rows that
+// agree on the key.
+//
+// Rows are produced in the same order as a nested loop join.
+void
+merge_join(const Filter& cond, Table* t1, Table* t2, const Join_key& key,
+           const std::vector<std::size_t>& s2, Join_rows& rows) {
+  const Column& c1 = *t1->column(key.left);
+  const Column& c2 = *t2->column(key.right);
+  std::vector<std::size_t> s1 = sort_column(c1);
+
+  bool residual = cond.nodes[cond.root].op != Filter::eq_op;
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  std::size_t a = 0;
+  std::size_t b = 0;
+  while (a < s1.size() and b < s2.size()) {
+    if (is_less(c1, s1[a], c2, s2[b])) {
+      ++a;
+      continue;
+    }
+    if (is_less(c2, s2[b], c1, s1[a])) {
+      // Skip the rows of t2 with smaller keys. When t1 has few rows,
+      // most of t2 is skipped.
+      auto less = [&](std::size_t j) { return is_less(c2, j, c1, s1[a]); };
+      b = std::partition_point(s2.begin() + b, s2.end(), less) - s2.begin();
+      continue;
+    }
+
+    // Find the rows of t2 having the same key, and pair them with
+    // each row of t1 having that key.
+    std::size_t last = b + 1;
+    while (last < s2.size() and not is_less(c2, s2[b], c2, s2[last]))
+      ++last;
+    std::size_t first = a;
+    while (a < s1.size() and not is_less(c1, s1[first], c1, s1[a])) {
+      std::size_t pair[2] = {s1[a], 0};
+      for (std::size_t j = b; j < last; ++j) {
+        pair[1] = s2[j];
+        if (residual and not cond.test(pair))
+          continue;
+        pairs.push_back({pair[0], pair[1]});
       }
-      ++cond_it;
-      ++table_it;
+      ++a;
     }
-    n_table->t1 = sel_rec;
+    b = last;
+  }
+
+  // Restore the order of the rows of t1, if they were sorted. The
+  // rows of t2 with the same key are already in order.
+  if (not std::is_sorted(s1.begin(), s1.end()))
+    std::sort(pairs.begin(), pairs.end());
+  rows.left.reserve(pairs.size());
+  rows.right.reserve(pairs.size());
+  for (const auto& p : pairs) {
+    rows.left.push_back(p.first);
+    rows.right.push_back(p.second);
   }
+}
 
-  return eval(n_table);
+// The number of rows above which a table is considered too large to
+// be partitioned in a hash table. Larger joins and set operations are
+// computed by sorting.
+constexpr std::size_t hash_limit = 1 << 20;
+
+// Returns true when the join on the given key should be computed by
+// merging sorted rows rather than by hashing. That is the case when
+// the right table is already sorted on its key or is too large to be
+// hashed. The rows of the left table are sorted as they arrive.
+bool
+use_merge_join(Table* t2, const Join_key& key) {
+  if (t2->rows() > hash_limit)
+    return true;
+  return is_sorted(*t2->column(key.right));
 }
 
+// Evaluation for 't1 join t2 on t3'
+//
+//    t1 ->* [r1, ..., rn]   t2 ->* [s1, ..., sm]
+//    ------------------------------------------------------ E-join
+//    t1 join t2 on t3 ->* [ri + sj | [t1->ri, t2->sj]t3 ->* true]
+//
+// The query is evaluated by its plan.
 Term*
 eval_join(Join* t) {
-  //perform product between tables
-  //perform selection of resulting product
-  //perform projection on table
-  //populate new table
-  //ereturn new table
-  return nullptr;
+  return eval_query(t);
+}
+
+// A set of values. Values are compared with is_same and hashed
+// structurally, so that equal records fall into the same bucket.
+using Value_set = std::unordered_set<Term*, Expr_hash, Expr_eq>;
+
+// Returns the rows of a that are (or are not) in b. Each row appears
+// once in the result, in the order it first appears in a.
+Table*
+hash_filter_table(Table* a, Table* b, bool in) {
+  Row_set right;
+  for (std::size_t j = 0; j < b->rows(); ++j)
+    right.insert(b, j);
+
+  Row_set seen;
+  std::vector<std::size_t> rows;
+  for (std::size_t i = 0; i < a->rows(); ++i)
+    if (right.contains(a, i) == in and seen.insert(a, i))
+      rows.push_back(i);
+  return select_rows(a, rows);
+}
+
+// Returns the first row of each run of equal rows in the sorted order
+// s of the table t. Since equal rows are sorted by index, this is the
+// first occurrence of each distinct row.
+std::vector<std::size_t>
+get_distinct_rows(Table* t, const std::vector<std::size_t>& s) {
+  std::vector<std::size_t> rows;
+  for (std::size_t i = 0; i < s.size(); ++i)
+    if (i == 0 or is_less_row(t, s[i - 1], t, s[i]))
+      rows.push_back(s[i]);
+  return rows;
+}
+
+// Returns the distinct rows ra of a that are (or are not) in b, where
+// ra and sb are in sorted order. The result is in the order of a.
+std::vector<std::size_t>
+merge_rows(Table* a, const std::vector<std::size_t>& ra,
+           Table* b, const std::vector<std::size_t>& sb, bool in) {
+  std::vector<std::size_t> rows;
+  std::size_t j = 0;
+  for (std::size_t i : ra) {
+    while (j < sb.size() and is_less_row(b, sb[j], a, i))
+      ++j;
+    bool found = j < sb.size() and not is_less_row(a, i, b, sb[j]);
+    if (found == in)
+      rows.push_back(i);
+  }
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+// Returns the rows of a that are (or are not) in b by sorting the
+// rows of both tables. The result is the same as for hashing.
+Table*
+sort_filter_table(Table* a, Table* b, bool in) {
+  std::vector<std::size_t> ra = get_distinct_rows(a, sort_table(a));
+  std::vector<std::size_t> sb = sort_table(b);
+  return select_rows(a, merge_rows(a, ra, b, sb, in));
 }
 
+// Returns true when a set operation on a and b should be computed by
+// sorting rather than by hashing. That is the case when both tables
+// are already sorted or are too large to hash.
+bool
+use_sort(Table* a, Table* b) {
+  if (a->rows() + b->rows() > hash_limit)
+    return true;
+  return is_sorted(a) and is_sorted(b);
+}
+
+// Returns the rows of a that are (or are not) in b.
+Table*
+filter_table(Table* a, Table* b, bool in) {
+  if (use_sort(a, b))
+    return sort_filter_table(a, b, in);
+  return hash_filter_table(a, b, in);
+}
+
+// Evaluation for 't1 intersect t2'
+//
+//    t1 ->* [v1, ..., vn]   t2 ->* [w1, ..., wm]
+//    --------------------------------------------- E-intersect
+//    t1 intersect t2 ->* [vi | vi in {w1, ..., wm}]
+//
+// Each value appears once in the result, in the order it first
+// appears in t1.
 Term*
 eval_intersect(Intersect* t) {
-  //eval t1
+  if (is_query(t))
+    return eval_query(t);
   Term* t1 = eval(t->t1);
-  Term_seq* e1 = as<List>(t1)->elems();
-  //eval t2
-  Term* t2 = eval(t->t2);
-  Term_seq* e2 = as<List>(t2)->elems();
-  //perform intersect
-  Term_seq* u = new Term_seq();
-  for(auto re1 : *e1) {
-    bool contained = false;
-    for(auto re2: *e2) {
-      if(is_same(re1, re2)) {
-        contained = true;
-        break;
-      }
-    }
-    if(contained)
-      u->push_back(re1);
-  }
+  Term_seq* e1 = eval_elems(as<List>(t1));
+  Term_seq* e2 = eval_elems(as<List>(eval(t->t2)));
 
-  //remove duplicates
+  Value_set right(e2->begin(), e2->end(), e2->size());
+  Value_set seen(e1->size());
+  Term_seq* u = new Term_seq();
+  for (Term* e : *e1)
+    if (right.count(e) and seen.insert(e).second)
+      u->push_back(e);
   return new List(get_type(t1), u);
 }
 
-//Assum t1 and t2 are both lists
+// Returns the rows of a followed by those of b. Each row appears once
+// in the result, in the order it first appears.
+Table*
+hash_union_tables(Table* a, Table* b) {
+  Table* u = make_table(get_type(a), a->rows() + b->rows());
+  Row_set seen;
+  for (std::size_t i = 0; i < a->rows(); ++i)
+    if (seen.insert(a, i))
+      append_row(u, a, i);
+  for (std::size_t i = 0; i < b->rows(); ++i)
+    if (seen.insert(b, i))
+      append_row(u, b, i);
+  return u;
+}
+
+// Returns the union of a and b by sorting the rows of both tables.
+// The result is the same as for hashing.
+Table*
+sort_union_tables(Table* a, Table* b) {
+  std::vector<std::size_t> sa = sort_table(a);
+  std::vector<std::size_t> ra = get_distinct_rows(a, sa);
+  std::vector<std::size_t> rb = get_distinct_rows(b, sort_table(b));
+  std::vector<std::size_t> first = ra;
+  std::sort(first.begin(), first.end());
+  std::vector<std::size_t> second = merge_rows(b, rb, a, sa, false);
+
+  Table* u = make_table(get_type(a), first.size() + second.size());
+  for (std::size_t i : first)
+    append_row(u, a, i);
+  for (std::size_t i : second)
+    append_row(u, b, i);
+  return u;
+}
+
+// Returns the union of the rows of a and b.
+Table*
+union_tables(Table* a, Table* b) {
+  if (use_sort(a, b))
+    return sort_union_tables(a, b);
+  return hash_union_tables(a, b);
+}
+
+// Evaluation for 't1 union t2'
+//
+//    t1 ->* [v1, ..., vn]   t2 ->* [w1, ..., wm]
+//    ---------------------------------------------- E-union
+//    t1 union t2 ->* [v1, ..., vn, w1, ..., wm]
+//
+// Each value appears once in the result, in the order it first
+// appears in t1 or t2.
 Term*
 eval_union(Union* t) {
-  //eval t1
+  if (is_query(t))
+    return eval_query(t);
   Term* t1 = eval(t->t1);
-  Term_seq* e1 = as<List>(t1)->elems();
-  //eval t2
-  Term* t2 = eval(t->t2);
-  Term_seq* e2 = as<List>(t2)->elems();
+  Term_seq* e1 = eval_elems(as<List>(t1));
+  Term_seq* e2 = eval_elems(as<List>(eval(t->t2)));
 
-  //perform union
+  Value_set seen(e1->size() + e2->size());
   Term_seq* u = new Term_seq();
-  u->assign(e1->begin(), e1->end());
-  for(auto e0 : *e2) {
-    bool contained = false;
-    for(auto elem : *u) {
-      //if we find it in the union set already break
-      if(is_same(e0, elem)) {
-        contained = true;
-        break;
-      } 
-    }
-    if(!contained)
-      u->push_back(e0);
-  }
+  for (Term* e : *e1)
+    if (seen.insert(e).second)
+      u->push_back(e);
+  for (Term* e : *e2)
+    if (seen.insert(e).second)
+      u->push_back(e);
   return new List(get_type(t1), u);
 }
 
-//Assume t1 and t2 are both lists
+// Evaluation for 'index t.k'
+//
+//    -------------------- E-index
+//    index t.k ->* unit
+//
+// Builds an index on the column 'k' of the table defined by t. The
+// index is kept with the column, and later selections and joins on
+// that column find rows through it.
+Term*
+eval_index(Index* t) {
+  Mem* m = as<Mem>(t->column());
+  Var* v = as<Var>(as<Ref>(m->member())->decl());
+  if (Table* table = as<Table>(eval(m->record())))
+    make_index(table->column(find_column(table, v->name())));
+  return get_unit();
+}
+
+// Evaluation for 'group t1 from t2'
+//
+//    t2 ->* [r1, ..., rn]
+//    ----------------------------------------------------- E-group
+//    group t1 from t2 ->* [t1(G1), ..., t1(Gm)]
+//
+// where G1, ..., Gm are the groups of rows of t2 having the same keys
+// in t1, in the order of their first rows, and t1(G) gives the keys
+// and aggregates of G. The query is evaluated by its plan.
+Term*
+eval_group(Group* t) {
+  return eval_query(t);
+}
+
+// Evaluation for 't1 except t2'
+//
+//    t1 ->* [v1, ..., vn]   t2 ->* [w1, ..., wm]
+//    ------------------------------------------------ E-except
+//    t1 except t2 ->* [vi | vi not in {w1, ..., wm}]
+//
+// Each value appears once in the result, in the order it first
+// appears in t1.
 Term*
 eval_except(Except* t) {
-  //eval t1
+  if (is_query(t))
+    return eval_query(t);
   Term* t1 = eval(t->t1);
-  Term_seq* e1 = as<List>(t1)->elems();
-  //eval t2
-  Term* t2 = eval(t->t2);
-  Term_seq* e2 = as<List>(t2)->elems();
-  //perform except
+  Term_seq* e1 = eval_elems(as<List>(t1));
+  Term_seq* e2 = eval_elems(as<List>(eval(t->t2)));
+
+  Value_set right(e2->begin(), e2->end(), e2->size());
+  Value_set seen(e1->size());
   Term_seq* u = new Term_seq();
-  for(auto re1 : *e1) {
-    bool contained = false;
-    for(auto re2: *e2) {
-      if(is_same(re1, re2)) {
-        contained = true;
-        break;
+  for (Term* e : *e1)
+    if (not right.count(e) and seen.insert(e).second)
+      u->push_back(e);
+  return new List(get_type(t1), u);
+}
+
+// -------------------------------------------------------------------------- //
+// Query evaluation
+//
+// Plans are evaluated by cursors. Each operator of a plan has a cursor
+// that produces the rows of its result a batch at a time, on demand,
+// by pulling batches from the cursors of its inputs. Selections and
+// projections hold only the current batch, so a pipeline of them runs
+// in memory bounded by the batch size. A join holds the rows of its
+// right input, and a set operation holds the rows it has seen.
+
+// The largest number of rows in a batch read from a table.
+constexpr std::size_t cursor_batch_size = 1024;
+
+// The interface to the evaluation of a plan.
+struct Cursor {
+  virtual ~Cursor() { }
+
+  // Prepare to produce rows.
+  virtual void open() = 0;
+
+  // Returns the next non-empty batch of rows, or nullptr when there
+  // are no more rows.
+  virtual Table* next() = 0;
+
+  // Release the resources held by the cursor.
+  virtual void close() = 0;
+};
+
+Cursor* make_cursor(Plan*);
+
+// Returns the rows produced by the cursor c as a single table of type
+// type. The cursor must be open. When it produces a single batch,
+// that batch is returned.
+Table*
+drain(Cursor* c, Type* type) {
+  Table* first = c->next();
+  if (not first)
+    return make_table(type, 0);
+  Table* second = c->next();
+  if (not second)
+    return first;
+  Table* t = make_table(type, first->rows() + second->rows());
+  auto append = [t](Table* b) {
+    for (std::size_t i = 0; i < b->rows(); ++i)
+      append_row(t, b, i);
+  };
+  append(first);
+  append(second);
+  while (Table* b = c->next())
+    append(b);
+  return t;
+}
+
+// Add the source tables of a filter over the result t of a plan with
+// the schema s to ss. The columns of each table in the schema form a
+// source, which shares its columns with t.
+void
+get_sources(const Plan_schema& s, Table* t, std::size_t input,
+            std::vector<Filter_source>& ss) {
+  std::vector<Def*> defs;
+  for (const Plan_column& c : s)
+    if (std::find(defs.begin(), defs.end(), c.def) == defs.end())
+      defs.push_back(c.def);
+  for (Def* d : defs) {
+    Term_seq* vars = new Term_seq();
+    std::vector<std::size_t> cols;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+      if (s[i].def == d) {
+        vars->push_back(s[i].var);
+        cols.push_back(i);
       }
     }
-    if(!contained)
-      u->push_back(re1);
+    Type* rec_type = get_record_type(vars);
+    Type* type = get_list_type(rec_type);
+    ss.push_back({d, project_table(t, type, cols), input});
   }
+}
 
-  //remove duplicates
-  return new List(get_type(t1), u);
+// Produces the rows of a table, a batch at a time. Tables small
+// enough to fit in a batch, and tables read as a whole, are produced
+// as they are, so that they keep the indexes on their columns.
+//
+// After the cursor is opened, the rows it produces can be restricted
+// to those found by an index.
+struct Scan_cursor : Cursor {
+  Scan_cursor(Scan_plan* p)
+    : plan(p) { }
+
+  void open() override {
+    table = as<Table>(eval(plan->table));
+    pos = 0;
+  }
+
+  Table* next() override {
+    if (restricted)
+      return next_rows();
+    if (pos == table->rows())
+      return nullptr;
+    if (pos == 0 and (whole or table->rows() <= cursor_batch_size)) {
+      pos = table->rows();
+      return table;
+    }
+    std::size_t count = std::min(cursor_batch_size, table->rows() - pos);
+    Table* t = slice_table(table, pos, count);
+    pos += count;
+    return t;
+  }
+
+  // Returns the next batch of the selected rows.
+  Table* next_rows() {
+    if (pos == rows.size())
+      return nullptr;
+    std::size_t count = std::min(cursor_batch_size, rows.size() - pos);
+    std::vector<std::size_t> batch(rows.begin() + pos, rows.begin() + pos + count);
+    pos += count;
+    return select_rows(table, batch);
+  }
+
+  // Produce only the given rows, which are in increasing order.
+  void restrict(std::vector<std::size_t>&& rs) {
+    rows = std::move(rs);
+    restricted = true;
+    pos = 0;
+  }
+
+  void close() override {
+    table = nullptr;
+    rows.clear();
+    restricted = false;
+  }
+
+  Scan_plan* plan;
+  Table* table = nullptr;
+  std::size_t pos = 0;
+  bool whole = false;
+  bool restricted = false;
+  std::vector<std::size_t> rows;
+};
+
+Scan_cursor* get_scan(Cursor*);
+bool use_index(Scan_cursor*, Term*);
+
+// Produces the rows of each batch of the input that satisfy the
+// condition. The condition is compiled once, for the first batch, and
+// then applied to the columns of each following batch.
+//
+// When the input reads a table with an index on a column compared by
+// the condition, only the rows found by the index are read.
+struct Filter_cursor : Cursor {
+  Filter_cursor(Filter_plan* p, Cursor* c)
+    : plan(p), input(c) { }
+
+  ~Filter_cursor() {
+    delete input;
+    delete filter;
+  }
+
+  void open() override {
+    input->open();
+    if (Scan_cursor* s = get_scan(input))
+      use_index(s, plan->cond);
+  }
+
+  Table* next() override {
+    while (Table* t = input->next()) {
+      std::vector<Filter_source> ss;
+      get_sources(plan->input->schema, t, 0, ss);
+      if (not filter)
+        filter = new Filter(plan->cond, ss);
+      else
+        filter->sources = ss;
+      std::vector<std::size_t> rows = filter->select();
+      if (rows.size() == t->rows())
+        return t;
+      if (not rows.empty())
+        return select_rows(t, rows);
+    }
+    return nullptr;
+  }
+
+  void close() override {
+    input->close();
+    delete filter;
+    filter = nullptr;
+  }
+
+  Filter_plan* plan;
+  Cursor* input;
+  Filter* filter = nullptr;
+};
+
+// Produces the columns of each batch of the input named by the
+// schema. The columns are shared with the input.
+struct Project_cursor : Cursor {
+  Project_cursor(Project_plan* p, Cursor* c)
+    : plan(p), input(c), type(get_type(p)) {
+    for (const Plan_column& col : p->schema)
+      cols.push_back(find_column(p->input->schema, col.def, col.var->name()));
+  }
+
+  ~Project_cursor() { delete input; }
+
+  void open() override { input->open(); }
+
+  Table* next() override {
+    if (Table* t = input->next())
+      return project_table(t, type, cols);
+    return nullptr;
+  }
+
+  void close() override { input->close(); }
+
+  Project_plan* plan;
+  Cursor* input;
+  Type* type;
+  std::vector<std::size_t> cols;
+};
+
+// Returns the cursor scanning the table read by c, if c produces the
+// rows of that table without selecting any of them.
+Scan_cursor*
+get_scan(Cursor* c) {
+  while (Project_cursor* p = dynamic_cast<Project_cursor*>(c))
+    c = p->input;
+  return dynamic_cast<Scan_cursor*>(c);
+}
+
+// If t has the form 'd.k' where 'd.k' is an indexed column of the
+// table read by s, returns that column. Otherwise, returns nullptr.
+Column*
+get_indexed_column(Scan_cursor* s, Term* t) {
+  Mem* m = as<Mem>(t);
+  if (not m)
+    return nullptr;
+  Ref* table = as<Ref>(m->record());
+  Ref* member = as<Ref>(m->member());
+  if (not table or not member or not as<Var>(member->decl()))
+    return nullptr;
+  const Plan_schema& schema = s->plan->schema;
+  for (std::size_t i = 0; i < schema.size(); ++i) {
+    const Plan_column& c = schema[i];
+    if (c.def == table->decl() and is_same(c.var->name(), as<Var>(member->decl())->name())) {
+      Column* col = s->table->column(i);
+      return col->index ? col : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+// Returns a column holding the value of the term t, which does not
+// refer to any row.
+Column
+get_key(Term* t) {
+  Term* v = eval(t);
+  Column key(get_column_kind(get_type(v)));
+  key.push_back(v);
+  return key;
+}
+
+// Restrict the rows read by s to those found by an index for one of
+// the conjuncts of the condition c. Conjuncts of the form 'd.k eq v',
+// 'd.k lt v', and 'v lt d.k' are used, where 'd.k' is indexed and v
+// does not refer to the table. Returns true if an index is used.
+bool
+use_index(Scan_cursor* s, Term* c) {
+  if (And* a = as<And>(c))
+    return use_index(s, a->t1) or use_index(s, a->t2);
+  if (Equals* e = as<Equals>(c)) {
+    Term* t1 = e->t1;
+    Term* t2 = e->t2;
+    Column* col = get_indexed_column(s, t1);
+    if (not col) {
+      std::swap(t1, t2);
+      col = get_indexed_column(s, t1);
+    }
+    if (not col or mentions(t2, s->plan->schema))
+      return false;
+    s->restrict(find_equal_rows(*col, get_key(t2)));
+    return true;
+  }
+  if (Less* l = as<Less>(c)) {
+    if (Column* col = get_indexed_column(s, l->t1)) {
+      if (mentions(l->t2, s->plan->schema))
+        return false;
+      s->restrict(find_less_rows(*col, get_key(l->t2)));
+      return true;
+    }
+    if (Column* col = get_indexed_column(s, l->t2)) {
+      if (mentions(l->t1, s->plan->schema))
+        return false;
+      s->restrict(find_greater_rows(*col, get_key(l->t1)));
+      return true;
+    }
+  }
+  return false;
+}
+
+// Produces the pairs of rows of the inputs satisfying the condition.
+// The right input is read when the cursor is opened. Each batch of the
+// left input is then joined with all of its rows.
+//
+// When the condition compares a column of one input with a column of
+// the other for equality, the rows of the right input are indexed by
+// hashing their key or, for sorted or large tables, by sorting them.
+// A table whose key column is already indexed is probed through that
+// index.
+// Otherwise, every pair of rows is tested. In both cases, the
+// condition is compiled into a filter over the columns of both inputs,
+// once, and applied to each batch.
+// The columns of the result are gathered from the matching rows of
+// each input.
+struct Join_cursor : Cursor {
+  Join_cursor(Join_plan* p, Cursor* l, Cursor* r)
+    : plan(p), left(l), right(r), type(get_type(p)) { }
+
+  ~Join_cursor() {
+    delete left;
+    delete right;
+    delete cond;
+  }
+
+  void open() override {
+    if (Scan_cursor* s = get_scan(right))
+      s->whole = true;
+    right->open();
+    table = drain(right, get_type(plan->right));
+    right->close();
+    left->open();
+
+    has_key = find_join_key(plan->cond, plan->left->schema, plan->right->schema, key);
+    if (not has_key)
+      return;
+    Column* col = table->column(key.right);
+    merge = use_merge_join(table, key);
+    if (col->index) {
+      order = &col->index->order;
+      index = &col->index->rows;
+    } else if (merge) {
+      sorted = sort_column(*col);
+      order = &sorted;
+    } else {
+      hashed = make_join_index(*col);
+      index = &hashed;
+    }
+  }
+
+  Table* next() override {
+    while (Table* t = left->next()) {
+      std::vector<Filter_source> ss;
+      get_sources(plan->left->schema, t, 0, ss);
+      get_sources(plan->right->schema, table, 1, ss);
+      if (not cond)
+        cond = new Filter(plan->cond, ss);
+      else
+        cond->sources = ss;
+      Join_rows rows;
+      if (not has_key)
+        nested_loop_join(*cond, t, table, rows);
+      else if (merge)
+        merge_join(*cond, t, table, key, *order, rows);
+      else
+        hash_join(*cond, t, table, key, *index, rows);
+      if (rows.left.empty())
+        continue;
+      Table* l = select_rows(t, rows.left);
+      Table* r = select_rows(table, rows.right);
+      return merge_tables(l, r, type);
+    }
+    return nullptr;
+  }
+
+  void close() override {
+    left->close();
+    delete cond;
+    cond = nullptr;
+    table = nullptr;
+    order = nullptr;
+    index = nullptr;
+    sorted.clear();
+    hashed.clear();
+  }
+
+  Join_plan* plan;
+  Cursor* left;
+  Cursor* right;
+  Type* type;
+  Table* table = nullptr;
+  Filter* cond = nullptr;
+  bool has_key = false;
+  Join_key key;
+  bool merge = false;
+  const std::vector<std::size_t>* order = nullptr;
+  const Join_index* index = nullptr;
+  std::vector<std::size_t> sorted;
+  Join_index hashed;
+};
+
+// Produces the rows of the left input followed by those of the right
+// input. Each row is produced once, in the order it first appears.
+//
+// When both inputs read whole tables, the union is computed from those
+// tables when the cursor is opened, by sorting them if they are sorted
+// or too large to hash. Otherwise, the rows are hashed as they arrive.
+struct Union_cursor : Cursor {
+  Union_cursor(Cursor* l, Cursor* r)
+    : left(l), right(r) { }
+
+  ~Union_cursor() {
+    delete left;
+    delete right;
+  }
+
+  void open() override {
+    left->open();
+    input = left;
+    Scan_cursor* a = dynamic_cast<Scan_cursor*>(left);
+    Scan_cursor* b = dynamic_cast<Scan_cursor*>(right);
+    if (not a or not b)
+      return;
+    right->open();
+    result = union_tables(a->table, b->table);
+    whole = true;
+    left->close();
+    input = right;
+  }
+
+  Table* next() override {
+    if (whole) {
+      Table* t = result;
+      result = nullptr;
+      if (t and t->rows())
+        return t;
+      return nullptr;
+    }
+    while (true) {
+      Table* t = input->next();
+      if (not t) {
+        if (input == right)
+          return nullptr;
+        left->close();
+        right->open();
+        input = right;
+        continue;
+      }
+      std::vector<std::size_t> rows;
+      for (std::size_t i = 0; i < t->rows(); ++i)
+        if (seen.insert(t, i))
+          rows.push_back(i);
+      if (rows.size() == t->rows())
+        return t;
+      if (not rows.empty())
+        return select_rows(t, rows);
+    }
+  }
+
+  void close() override {
+    input->close();
+    result = nullptr;
+    whole = false;
+    seen.buckets.clear();
+  }
+
+  Cursor* left;
+  Cursor* right;
+  Cursor* input = nullptr;
+  Table* result = nullptr;
+  bool whole = false;
+  Row_set seen;
+};
+
+// Produces the rows of the left input that are (or are not) in the
+// right input. Each row is produced once, in the order it first
+// appears. The right input is read when the cursor is opened. When it
+// is sorted or too large to hash, the left input is read as well, and
+// the result is computed from both tables, by sorting them if they are
+// sorted or too large to hash.
+struct Filter_table_cursor : Cursor {
+  Filter_table_cursor(Set_plan* p, Cursor* l, Cursor* r, bool in)
+    : plan(p), left(l), right(r), in(in) { }
+
+  ~Filter_table_cursor() {
+    delete left;
+    delete right;
+  }
+
+  void open() override {
+    right->open();
+    table = drain(right, get_type(plan->right));
+    right->close();
+    left->open();
+    if (table->rows() > hash_limit or is_sorted(table)) {
+      Table* a = drain(left, get_type(plan->left));
+      result = filter_table(a, table, in);
+      return;
+    }
+    for (std::size_t j = 0; j < table->rows(); ++j)
+      rows.insert(table, j);
+  }
+
+  Table* next() override {
+    // When the left input has already been read, the result is known.
+    if (Table* t = result) {
+      result = nullptr;
+      if (t->rows())
+        return t;
+    }
+    while (Table* t = left->next()) {
+      std::vector<std::size_t> keep;
+      for (std::size_t i = 0; i < t->rows(); ++i)
+        if (rows.contains(t, i) == in and seen.insert(t, i))
+          keep.push_back(i);
+      if (keep.size() == t->rows())
+        return t;
+      if (not keep.empty())
+        return select_rows(t, keep);
+    }
+    return nullptr;
+  }
+
+  void close() override {
+    left->close();
+    table = nullptr;
+    result = nullptr;
+    rows.buckets.clear();
+    seen.buckets.clear();
+  }
+
+  Set_plan* plan;
+  Cursor* left;
+  Cursor* right;
+  bool in;
+  Table* table = nullptr;
+  Table* result = nullptr;
+  Row_set rows;
+  Row_set seen;
+};
+
+// Produces the keys and aggregates of the groups of rows of the
+// input. The input is read, a batch at a time, when the cursor is
+// opened, and the groups are produced as a single batch.
+struct Group_cursor : Cursor {
+  Group_cursor(Group_plan* p, Cursor* c)
+    : plan(p), input(c) {
+    for (const Plan_group_item& i : p->items) {
+      std::size_t n = find_column(p->input->schema, i.column.def, i.column.var->name());
+      items.push_back({i.key, i.op, n});
+    }
+  }
+
+  ~Group_cursor() { delete input; }
+
+  void open() override {
+    Grouping g(get_type(plan), items);
+    input->open();
+    while (Table* t = input->next())
+      g.add(t);
+    input->close();
+    result = g.result();
+  }
+
+  Table* next() override {
+    Table* t = result;
+    result = nullptr;
+    if (t and t->rows())
+      return t;
+    return nullptr;
+  }
+
+  void close() override { result = nullptr; }
+
+  Group_plan* plan;
+  Cursor* input;
+  std::vector<Group_item> items;
+  Table* result = nullptr;
+};
+
+// Returns a cursor evaluating the plan p.
+Cursor*
+make_cursor(Plan* p) {
+  switch (p->kind) {
+  case scan_plan:
+    return new Scan_cursor(static_cast<Scan_plan*>(p));
+  case filter_plan: {
+    Filter_plan* f = static_cast<Filter_plan*>(p);
+    return new Filter_cursor(f, make_cursor(f->input));
+  }
+  case project_plan: {
+    Project_plan* j = static_cast<Project_plan*>(p);
+    return new Project_cursor(j, make_cursor(j->input));
+  }
+  case join_plan: {
+    Join_plan* j = static_cast<Join_plan*>(p);
+    return new Join_cursor(j, make_cursor(j->left), make_cursor(j->right));
+  }
+  case union_plan: {
+    Set_plan* s = static_cast<Set_plan*>(p);
+    return new Union_cursor(make_cursor(s->left), make_cursor(s->right));
+  }
+  case intersect_plan: {
+    Set_plan* s = static_cast<Set_plan*>(p);
+    return new Filter_table_cursor(s, make_cursor(s->left), make_cursor(s->right), true);
+  }
+  case except_plan: {
+    Set_plan* s = static_cast<Set_plan*>(p);
+    return new Filter_table_cursor(s, make_cursor(s->left), make_cursor(s->right), false);
+  }
+  case group_plan: {
+    Group_plan* g = static_cast<Group_plan*>(p);
+    return new Group_cursor(g, make_cursor(g->input));
+  }
+  }
+  lang_unreachable("evaluating unknown plan");
+}
+
+// An open cursor over the rows of a query. The query is translated
+// into a plan, which is optimized before it is evaluated. The cursor
+// is closed, and it and the plan are deleted, when the query goes out
+// of scope.
+struct Open_query {
+  Open_query(Term* t)
+    : plan(optimize(make_plan(t))), cursor(make_cursor(plan)) {
+    cursor->open();
+  }
+
+  ~Open_query() {
+    cursor->close();
+    delete cursor;
+    delete plan;
+  }
+
+  Plan* plan;
+  Cursor* cursor;
+};
+
+// Evaluate the query t. The result has the type of t.
+Term*
+eval_query(Term* t) {
+  Open_query q(t);
+  Table* result = drain(q.cursor, get_type(t));
+  return new Table(get_type(t), result->columns());
+}
+
+// Print the rows of the query t as they are produced.
+void
+print_query(std::ostream& os, Term* t) {
+  Open_query q(t);
+  os << '[';
+  bool first = true;
+  while (Table* b = q.cursor->next()) {
+    for (std::size_t i = 0; i < b->rows(); ++i) {
+      if (not first)
+        os << ", ";
+      os << pretty(get_row(b, i));
+      first = false;
+    }
+  }
+  os << ']';
 }
 
 } // namespace
 
 // Compute the multi-step evaluation of the term t. 
+//
+// Terms in tail position (the selected branch of an if, the reduced
+// body of an application or call, and the last statement of a
+// program) are evaluated by iteration rather than recursion, so that
+// a chain of tail calls runs in constant native stack.
 Term*
 eval(Term* t) {
-  switch (t->kind) {
-  case if_term: return eval_if(as<If>(t));
-  case and_term: return eval_and(as<And>(t));
-  case or_term: return eval_or(as<Or>(t));
-  case not_term: return eval_not(as<Not>(t));
-  case equals_term: return eval_equals(as<Equals>(t));
-  case less_term: return eval_less(as<Less>(t));
-  case succ_term: return eval_succ(as<Succ>(t));
-  case pred_term: return eval_pred(as<Pred>(t));
-  case iszero_term: return eval_iszero(as<Iszero>(t));
-  case app_term: return eval_app(as<App>(t));
-  case call_term: return eval_call(as<Call>(t));
-  case ref_term: return eval_ref(as<Ref>(t));
-  case print_term: return eval_print(as<Print>(t));
-  case def_term: return eval_def(as<Def>(t));
-  case prog_term: return eval_prog(as<Prog>(t));
-  case comma_term: return eval_comma(as<Comma>(t));
-  case proj_term: return eval_proj(as<Proj>(t));
-  case mem_term: return eval_mem(as<Mem>(t));
-  //case col_term: return eval_col(as<Col>(t));
-  case select_term: return eval_select_from_where(as<Select_from_where>(t));
-  case join_on_term: return eval_join(as<Join>(t));
-  case union_term: return eval_union(as<Union>(t));
-  case intersect_term: return eval_intersect(as<Intersect>(t));
-  case except_term: return eval_except(as<Except>(t));
-  default: break;
+  for (;;) {
+    switch (t->kind) {
+    case if_term: t = eval_if(as<If>(t)); continue;
+    case app_term: t = eval_app(as<App>(t)); continue;
+    case call_term: t = eval_call(as<Call>(t)); continue;
+    case prog_term: t = eval_prog(as<Prog>(t)); continue;
+    case and_term: return eval_and(as<And>(t));
+    case or_term: return eval_or(as<Or>(t));
+    case not_term: return eval_not(as<Not>(t));
+    case equals_term: return eval_equals(as<Equals>(t));
+    case less_term: return eval_less(as<Less>(t));
+    case succ_term: return eval_succ(as<Succ>(t));
+    case pred_term: return eval_pred(as<Pred>(t));
+    case iszero_term: return eval_iszero(as<Iszero>(t));
+    case ref_term: return eval_ref(as<Ref>(t));
+    case print_term: return eval_print(as<Print>(t));
+    case def_term: return eval_def(as<Def>(t));
+    case comma_term: return eval_comma(as<Comma>(t));
+    case list_term: return eval_list(as<List>(t));
+    case tuple_term: return eval_tuple(as<Tuple>(t));
+    case record_term: return eval_record(as<Record>(t));
+    case proj_term: return eval_proj(as<Proj>(t));
+    case mem_term: return eval_mem(as<Mem>(t));
+    //case col_term: return eval_col(as<Col>(t));
+    case select_term: return eval_select_from_where(as<Select_from_where>(t));
+    case join_on_term: return eval_join(as<Join>(t));
+    case union_term: return eval_union(as<Union>(t));
+    case intersect_term: return eval_intersect(as<Intersect>(t));
+    case except_term: return eval_except(as<Except>(t));
+    case index_term: return eval_index(as<Index>(t));
+    case group_term: return eval_group(as<Group>(t));
+    default: break;
+    }
+    return t;
   }
-  return t;
 }
 
 
-// Compute the one-step evaluation of the term t.
+
+// -------------------------------------------------------------------------- //
+// One-step evaluation
+//
+// The following functions compute the one-step evaluation of a term
+// t, written 't -> t''. Each returns the term after one step, or
+// nullptr when no rule applies (i.e., t is a normal form). Subterms
+// are reduced from left to right, and functions are applied by
+// substitution, as in the multi-step rules.
+//
+// Lists of records, member accesses, and queries are reduced in one
+// step by their multi-step rules.
+
+namespace {
+
+// Step the operands of the binary term t, from left to right. Returns
+// nullptr when both operands are normal forms.
+//
+//          t1 -> t1'
+//    --------------------- E-op-1
+//    t1 op t2 -> t1' op t2
+//
+//          t2 -> t2'
+//    --------------------- E-op-2
+//    v1 op t2 -> v1 op t2'
+template<typename T>
+  Term*
+  step_operands(T* t) {
+    if (Term* t1 = step(t->t1))
+      return new T(t->loc, get_type(t), t1, t->t2);
+    if (Term* t2 = step(t->t2))
+      return new T(t->loc, get_type(t), t->t1, t2);
+    return nullptr;
+  }
+
+// Step the operand of the unary term t. Returns nullptr when the
+// operand is a normal form.
+//
+//        t1 -> t1'
+//    ----------------- E-op
+//    op t1 -> op t1'
+template<typename T>
+  Term*
+  step_operand(T* t) {
+    if (Term* t1 = step(t->t1))
+      return new T(t->loc, get_type(t), t1);
+    return nullptr;
+  }
+
+// Step an if term.
+//
+//                       t1 -> t1'
+//    ------------------------------------------------ E-if
+//    if t1 then t2 else t3 -> if t1' then t2 else t3
+//
+//    ----------------------------- E-if-true
+//    if true then t2 else t3 -> t2
+//
+//    ------------------------------ E-if-false
+//    if false then t2 else t3 -> t3
+Term*
+step_if(If* t) {
+  if (Term* t1 = step(t->cond()))
+    return new If(t->loc, get_type(t), t1, t->if_true(), t->if_false());
+  if (is_true(t->cond()))
+    return t->if_true();
+  if (is_false(t->cond()))
+    return t->if_false();
+  lang_unreachable(format("'{}' is not a boolean value", pretty(t->cond())));
+}
+
+// Step a successor term.
+//
+//    ------------- E-succ-n
+//    succ n -> n+1
+Term*
+step_succ(Succ* t) {
+  if (Term* t1 = step_operand(t))
+    return t1;
+  if (Int* n = as<Int>(t->arg()))
+    return get_int(n->value() + Integer(1l));
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t->arg())));
+}
+
+// Step a predecessor term.
+//
+//    ----------- E-pred-0
+//    pred 0 -> 0
+//
+//    ------------- E-pred-n
+//    pred n -> n-1
+Term*
+step_pred(Pred* t) {
+  if (Term* t1 = step_operand(t))
+    return t1;
+  if (Int* n = as<Int>(t->arg())) {
+    if (n->value() == 0)
+      return n;
+    return get_int(n->value() - Integer(1l));
+  }
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t->arg())));
+}
+
+// Step an iszero term.
+//
+//    ------------------ E-iszero-0
+//    iszero 0 -> true
+//
+//    ------------------ E-iszero-n
+//    iszero n -> false
+Term*
+step_iszero(Iszero* t) {
+  if (Term* t1 = step_operand(t))
+    return t1;
+  if (Int* n = as<Int>(t->arg()))
+    return n->value() == 0 ? get_true() : get_false();
+  lang_unreachable(format("'{}' is not a numeric value", pretty(t->arg())));
+}
+
+// Step 'v1 and v2', 'v1 or v2', 'not v1', 'v1 eq v2', and 'v1 lt v2'
+// by the multi-step rules, once the operands are normal forms.
+Term*
+step_and(And* t) {
+  if (Term* t1 = step_operands(t))
+    return t1;
+  return is_true(t->t1) and is_true(t->t2) ? get_true() : get_false();
+}
+
+Term*
+step_or(Or* t) {
+  if (Term* t1 = step_operands(t))
+    return t1;
+  return is_false(t->t1) and is_false(t->t2) ? get_false() : get_true();
+}
+
+Term*
+step_not(Not* t) {
+  if (Term* t1 = step_operand(t))
+    return t1;
+  if (is_true(t->t1))
+    return get_false();
+  if (is_false(t->t1))
+    return get_true();
+  lang_unreachable(format("'{}' is not a boolean value", pretty(t->t1)));
+}
+
+Term*
+step_equals(Equals* t) {
+  if (Term* t1 = step_operands(t))
+    return t1;
+  return is_same(t->t1, t->t2) ? get_true() : get_false();
+}
+
+Term*
+step_less(Less* t) {
+  if (Term* t1 = step_operands(t))
+    return t1;
+  return is_less(t->t1, t->t2) ? get_true() : get_false();
+}
+
+// Step an application.
+//
+//    ---------------------- E-app-abs
+//    (\x:T.t) v -> [x->v]t
+Term*
+step_app(App* t) {
+  if (Term* t1 = step_operands(t))
+    return t1;
+  Abs* fn = as<Abs>(t->abs());
+  lang_assert(fn, format("ill-formed application target '{}'", pretty(t->abs())));
+  Subst sub {fn->var(), t->arg()};
+  return subst_term(fn->term(), sub);
+}
+
+// Step a function call. The function is reduced first, and then each
+// argument in turn.
+//
+//    ---------------------------------------------------------- E-call-fn
+//    (\(x1:T1, ..., xn:Tn).t)(v1, ..., vn) -> [x1->v1, ..., xn->vn]t
+Term*
+step_call(Call* t) {
+  if (Term* t1 = step(t->fn()))
+    return new Call(t->loc, get_type(t), t1, t->args());
+  Term_seq* args = t->args();
+  for (std::size_t i = 0; i < args->size(); ++i) {
+    if (Term* a = step((*args)[i])) {
+      Term_seq* as = new Term_seq();
+      as->assign(args->begin(), args->end());
+      (*as)[i] = a;
+      return new Call(t->loc, get_type(t), t->fn(), as);
+    }
+  }
+  Fn* fn = as<Fn>(t->fn());
+  lang_assert(fn, format("ill-formed call target '{}'", pretty(t->fn())));
+  Subst sub {fn->parms(), args};
+  return subst_term(fn->term(), sub);
+}
+
+// Step a reference to a definition.
+//
+//    def x = v
+//    --------- E-ref
+//     x -> v
+//
+// References to other declarations, and to definitions of types, are
+// normal forms.
+Term*
+step_ref(Ref* t) {
+  if (Def* def = as<Def>(t->decl()))
+    return as<Term>(def->value());
+  return nullptr;
+}
+
+// Step a definition. The definition is updated in place, since other
+// terms refer to it.
+//
+//             t -> t'
+//    ----------------------- E-def
+//    def x = t -> def x = t'
+Term*
+step_def(Def* t) {
+  if (Term* t0 = as<Term>(t->value())) {
+    if (Term* t1 = step(t0)) {
+      t->t2 = t1;
+      return t;
+    }
+  }
+  return nullptr;
+}
+
+// Step a print statement. The rows of a query are printed in one step,
+// as they are produced.
+//
+//          t -> t'
+//    ------------------- E-print
+//    print t -> print t'
+//
+//    --------------- E-print-value
+//    print v -> unit
+Term*
+step_print(Print* t) {
+  if (Term* t0 = as<Term>(t->expr())) {
+    if (is_query(t0))
+      return eval_print(t);
+    if (Term* t1 = step(t0))
+      return new Print(t->loc, get_type(t), t1);
+  }
+  *output << pretty(t->expr()) << '\n';
+  return get_unit();
+}
+
+// Step the first statement of a program that is not a normal form.
+// A program whose statements are all normal forms steps to its last
+// statement.
+//
+//                       ti -> ti'
+//    ------------------------------------------------- E-prog
+//    v1; ...; ti; ...; tn -> v1; ...; ti'; ...; tn
+//
+//    ------------------ E-prog-value
+//    v1; ...; vn -> vn
+Term*
+step_prog(Prog* t) {
+  Term_seq* ss = t->stmts();
+  if (ss->empty())
+    return get_unit();
+  for (std::size_t i = 0; i < ss->size(); ++i) {
+    if (Term* si = step((*ss)[i])) {
+      Term_seq* ts = new Term_seq();
+      ts->assign(ss->begin(), ss->end());
+      (*ts)[i] = si;
+      return new Prog(get_type(t), ts);
+    }
+  }
+  return ss->back();
+}
+
+// Reduce the term t by its multi-step rule, in a single step. Returns
+// nullptr when t evaluates to itself. This is used for queries, which
+// are evaluated by their plans, and for projections and set operations
+// once their operands are normal forms. Each is charged a single step.
+Term*
+step_whole(Term* t) {
+  Term* t1 = eval(t);
+  return t1 == t ? nullptr : t1;
+}
+
+// Step the first term of ts that is not a normal form. Returns a copy
+// of ts with that term stepped, or nullptr when every term of ts is a
+// normal form.
+Term_seq*
+step_elems(Term_seq* ts) {
+  for (std::size_t i = 0; i < ts->size(); ++i) {
+    if (Term* ti = step((*ts)[i])) {
+      Term_seq* r = new Term_seq();
+      r->assign(ts->begin(), ts->end());
+      (*r)[i] = ti;
+      return r;
+    }
+  }
+  return nullptr;
+}
+
+// Step the value of an initializer.
+//
+//          t -> t'
+//    ------------------- E-init
+//    n = t -> n = t'
+Term*
+step_init(Init* t) {
+  if (Term* t1 = step(as<Term>(t->value())))
+    return new Init(t->loc, get_type(t), t->name(), t1);
+  return nullptr;
+}
+
+// Step the first element of a tuple that is not a value. The elements
+// of records and lists are stepped in the same way.
+//
+//                       ti -> ti'
+//    ------------------------------------------------- E-tuple
+//    {v1, ..., ti, ..., tn} -> {v1, ..., ti', ..., tn}
+Term*
+step_tuple(Tuple* t) {
+  if (is_tuple_value(t))
+    return nullptr;
+  if (Term_seq* ts = step_elems(t->elems()))
+    return new Tuple(t->loc, get_type(t), ts);
+  return nullptr;
+}
+
+Term*
+step_record(Record* t) {
+  if (is_record_value(t))
+    return nullptr;
+  if (Term_seq* ts = step_elems(t->members()))
+    return new Record(t->loc, get_type(t), ts);
+  return nullptr;
+}
+
+// A list of records whose elements are values is stored as a table in
+// one more step (see eval_list).
+//
+//    ------------------------------------------------ E-table
+//    [r1, ..., rn] -> [l1=[v11, ..., vn1], ..., lk=[v1k, ..., vnk]]
+Term*
+step_list(List* t) {
+  if (not is_list_value(t)) {
+    if (Term_seq* ts = step_elems(t->elems()))
+      return new List(t->loc, get_type(t), ts);
+  }
+  if (is_table_type(get_type(t)))
+    return eval_list(t);
+  return nullptr;
+}
+
+// Step the record of a member projection or the tuple of an element
+// projection. Once it is a normal form, the projection is reduced in
+// one step.
+//
+//       t1 -> t1'
+//    --------------- E-mem
+//    t1.n -> t1'.n
+template<typename T>
+  Term*
+  step_member(T* t) {
+    if (Term* t1 = step(t->t1))
+      return new T(t->loc, get_type(t), t1, t->t2);
+    return step_whole(t);
+  }
+
+// Step the operands of a set operation. Once they are normal forms,
+// the operation is reduced in one step.
+template<typename T>
+  Term*
+  step_set(T* t) {
+    if (Term* t1 = step_operands(t))
+      return t1;
+    return step_whole(t);
+  }
+
+} // namespace
+
+// Compute the one-step evaluation of the term t. Returns nullptr when
+// t is a normal form.
 Term*
 step(Term* t) {
-  lang_unreachable("not implemented");
+  switch (t->kind) {
+  case if_term: return step_if(as<If>(t));
+  case and_term: return step_and(as<And>(t));
+  case or_term: return step_or(as<Or>(t));
+  case not_term: return step_not(as<Not>(t));
+  case equals_term: return step_equals(as<Equals>(t));
+  case less_term: return step_less(as<Less>(t));
+  case succ_term: return step_succ(as<Succ>(t));
+  case pred_term: return step_pred(as<Pred>(t));
+  case iszero_term: return step_iszero(as<Iszero>(t));
+  case app_term: return step_app(as<App>(t));
+  case call_term: return step_call(as<Call>(t));
+  case ref_term: return step_ref(as<Ref>(t));
+  case def_term: return step_def(as<Def>(t));
+  case print_term: return step_print(as<Print>(t));
+  case prog_term: return step_prog(as<Prog>(t));
+  case comma_term: return get_unit();
+  case init_term: return step_init(as<Init>(t));
+  case tuple_term: return step_tuple(as<Tuple>(t));
+  case record_term: return step_record(as<Record>(t));
+  case list_term: return step_list(as<List>(t));
+  case proj_term: return step_member(as<Proj>(t));
+  case mem_term: return step_member(as<Mem>(t));
+  case union_term: return step_set(as<Union>(t));
+  case intersect_term: return step_set(as<Intersect>(t));
+  case except_term: return step_set(as<Except>(t));
+  case select_term:
+  case join_on_term:
+  case index_term:
+  case group_term: return step_whole(t);
+  default: return nullptr;
+  }
+}
+
+// Evaluate the term t by at most n steps. When the evaluation reaches
+// a normal form, the result is done. Otherwise, the result holds the
+// term reached after n steps, and evaluating that term resumes the
+// evaluation. Note that a term that reaches a normal form on its last
+// step is not known to be done; resuming it takes no further steps.
+//
+// The statements of a program are evaluated in turn, so each step
+// only reduces the current statement. A suspended program holds the
+// remaining statements.
+Step_result
+step(Term* t, std::size_t n) {
+  Step_result r {t, false, 0};
+  if (Prog* p = as<Prog>(t)) {
+    Term_seq* ss = p->stmts();
+    r.term = get_unit();
+    for (std::size_t i = 0; i < ss->size(); ++i) {
+      Step_result ri = step((*ss)[i], n - r.steps);
+      r.steps += ri.steps;
+      r.term = ri.term;
+      if (not ri.done) {
+        Term_seq* rest = new Term_seq();
+        rest->push_back(ri.term);
+        rest->insert(rest->end(), ss->begin() + i + 1, ss->end());
+        r.term = new Prog(get_type(p), rest);
+        return r;
+      }
+    }
+    r.done = true;
+    return r;
+  }
+
+  while (r.steps < n) {
+    Term* t1 = step(r.term);
+    if (not t1) {
+      r.done = true;
+      return r;
+    }
+    r.term = t1;
+    ++r.steps;
+  }
+  return r;
+}
+
+// Returns true when t1 steps to t2 (i.e., t1 -> t2).
+bool
+is_step(Term* t1, Term* t2) {
+  Term* t = step(t1);
+  return t and is_same(t, t2);
+}
+
+// Returns true when t1 evaluates to t2 (i.e., t1 ->* t2).
+bool
+is_eval(Term* t1, Term* t2) {
+  return is_same(eval(t1), t2);
 }
 
@@ -3,21 +3,69 @@
 #define EVAL_HPP
 
 #include "lang/error.hpp"
+#include "lang/arena.hpp"
+
+#include <cstddef>
+#include <iosfwd>
 
 // This module defines the interface to the evaluation rules of
 // the programming language.
 
 struct Term;
+struct Print;
+
+// The ways in which a program can be evaluated.
+enum Eval_mode {
+  subst_eval, // Beta reduction by substitution (the reference rules)
+  env_eval,   // Evaluation in environments, with closures (see env.hpp)
+  vm_eval,    // Compilation to bytecode (see vm.hpp)
+  step_eval,  // One step at a time, with a limited number of steps
+  lazy_eval,  // Call-by-need evaluation in environments (see env.hpp)
+};
 
 // The evaluator class is the primary interface for evaluating
 // terms. Note that it keeps its own 
+//
+// When evaluating by steps, at most 'fuel' steps are taken. If the
+// program has not finished by then, the evaluator is suspended, and
+// the result is the remaining program.
+//
+// When 'memo' is not 0, the substitution evaluator caches the values
+// of up to 'memo' function calls (see memo.hpp).
+//
+// When 'threads' is greater than 1, the substitution evaluator runs
+// independent statements of a program on that many threads (see
+// par.hpp). Calls are not memoized in that case.
+//
+// The terms created during evaluation are allocated in the evaluator's
+// arena, so the result lives only as long as the evaluator.
 struct Evaluator {
+  Evaluator(Eval_mode m = subst_eval, std::size_t f = -1)
+    : mode(m), fuel(f) { }
+
   Term* operator()(Term*);
 
+  Eval_mode mode;
+  std::size_t fuel;
+  std::size_t memo = 0;
+  std::size_t threads = 1;
+  bool suspended = false;
   Diagnostics diags;
+  Arena arena;
+};
+
+// The result of evaluating a term by a limited number of steps. When
+// the evaluation is not done, the term is the remaining computation.
+struct Step_result {
+  Term* term;
+  bool done;
+  std::size_t steps;
 };
 
 Term* step(Term*);
+Step_result step(Term*, std::size_t);
 Term* eval(Term*);
+Term* eval_print(Print*, std::ostream&);
+std::ostream* set_output(std::ostream*);
 
 #endif
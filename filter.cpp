@@ -0,0 +1,530 @@
+#include "filter.hpp"
+#include "eval.hpp"
+#include "type.hpp"
+#include "value.hpp"
+#include "subst.hpp"
+
+#include "lang/debug.hpp"
+
+#include <algorithm>
+
+// -------------------------------------------------------------------------- //
+// Cells
+
+namespace {
+
+// Returns a cell holding the value t.
+Cell
+get_cell(Term* t) {
+  Cell c {term_column, 0, String(), t};
+  if (is_true(t) or is_false(t)) {
+    c.kind = bool_column;
+    c.nat = is_true(t);
+  } else if (Int* n = as<Int>(t)) {
+    const mpz_t& z = n->value().data();
+    if (mpz_fits_slong_p(z)) {
+      c.kind = nat_column;
+      c.nat = mpz_get_ui(z);
+    }
+  } else if (Str* s = as<Str>(t)) {
+    c.kind = str_column;
+    c.str = s->value();
+  }
+  return c;
+}
+
+// Returns a cell holding the nth value of the column c.
+Cell
+get_cell(const Column& c, std::size_t n) {
+  switch (c.kind) {
+  case bool_column: return {bool_column, c.bools[n], String(), nullptr};
+  case nat_column: return {nat_column, c.nats[n], String(), nullptr};
+  case str_column: return {str_column, 0, c.strs[n], nullptr};
+  case term_column: return get_cell(c.terms[n]);
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns a boolean cell.
+inline Cell
+get_bool_cell(bool b) { return {bool_column, b, String(), nullptr}; }
+
+// Returns the value of the cell c as a term.
+Term*
+get_term(const Cell& c) {
+  switch (c.kind) {
+  case bool_column: return c.nat ? get_true() : get_false();
+  case nat_column: return get_int(c.nat);
+  case str_column: return new Str(get_str_type(), c.str);
+  case term_column: return c.term;
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns true when the cell c is the value true.
+inline bool
+is_true(const Cell& c) { return c.kind == bool_column and c.nat; }
+
+// Returns true when a and b are the same value. This is consistent
+// with is_same on the corresponding terms.
+bool
+is_same(const Cell& a, const Cell& b) {
+  if (a.kind != b.kind)
+    return false;
+  switch (a.kind) {
+  case bool_column: return a.nat == b.nat;
+  case nat_column: return a.nat == b.nat;
+  case str_column: return a.str == b.str;
+  case term_column: return is_same(a.term, b.term);
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns true when a is less than b. This is consistent with is_less
+// on the corresponding terms.
+bool
+is_less(const Cell& a, const Cell& b) {
+  if (a.kind == nat_column and b.kind == nat_column)
+    return a.nat < b.nat;
+  return is_less(get_term(a), get_term(b));
+}
+
+// Returns true when the term t may refer to the definition of one of
+// the source tables. Terms whose form is not known are assumed to
+// refer to them.
+bool
+mentions(Term* t, const std::vector<Filter_source>& ss) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+    return false;
+  case ref_term: {
+    Expr* d = as<Ref>(t)->decl();
+    for (const Filter_source& s : ss)
+      if (s.def == d)
+        return true;
+    return false;
+  }
+  case mem_term:
+    return mentions(as<Mem>(t)->record(), ss);
+  case and_term:
+    return mentions(as<And>(t)->t1, ss) or mentions(as<And>(t)->t2, ss);
+  case or_term:
+    return mentions(as<Or>(t)->t1, ss) or mentions(as<Or>(t)->t2, ss);
+  case equals_term:
+    return mentions(as<Equals>(t)->t1, ss) or mentions(as<Equals>(t)->t2, ss);
+  case less_term:
+    return mentions(as<Less>(t)->t1, ss) or mentions(as<Less>(t)->t2, ss);
+  case not_term:
+    return mentions(as<Not>(t)->t1, ss);
+  case succ_term:
+    return mentions(as<Succ>(t)->t1, ss);
+  case pred_term:
+    return mentions(as<Pred>(t)->t1, ss);
+  case iszero_term:
+    return mentions(as<Iszero>(t)->t1, ss);
+  default:
+    return true;
+  }
+}
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Filter compilation
+
+// Compile the condition c against the given source tables.
+Filter::Filter(Term* c, const std::vector<Filter_source>& ss)
+  : sources(ss) {
+  root = compile(c);
+}
+
+// Add the node n to the filter, returning its index.
+std::size_t
+Filter::add(const Node& n) {
+  nodes.push_back(n);
+  return nodes.size() - 1;
+}
+
+// Compile the term t, returning the index of its node.
+std::size_t
+Filter::compile(Term* t) {
+  Node n {const_op, get_bool_cell(false), 0, 0, 0, 0, t};
+  switch (t->kind) {
+  case mem_term: {
+    std::size_t col = compile_column(as<Mem>(t));
+    if (col != std::size_t(-1))
+      return col;
+    break;
+  }
+  case equals_term:
+    n.op = eq_op;
+    n.n1 = compile(as<Equals>(t)->t1);
+    n.n2 = compile(as<Equals>(t)->t2);
+    return add(n);
+  case less_term:
+    n.op = less_op;
+    n.n1 = compile(as<Less>(t)->t1);
+    n.n2 = compile(as<Less>(t)->t2);
+    return add(n);
+  case and_term:
+    n.op = and_op;
+    n.n1 = compile(as<And>(t)->t1);
+    n.n2 = compile(as<And>(t)->t2);
+    return add(n);
+  case or_term:
+    n.op = or_op;
+    n.n1 = compile(as<Or>(t)->t1);
+    n.n2 = compile(as<Or>(t)->t2);
+    return add(n);
+  case not_term:
+    n.op = not_op;
+    n.n1 = compile(as<Not>(t)->t1);
+    return add(n);
+  default:
+    break;
+  }
+
+  // The term does not depend on the row, so evaluate it now.
+  if (not mentions(t, sources)) {
+    n.value = get_cell(::eval(t));
+    return add(n);
+  }
+
+  n.op = term_op;
+  return add(n);
+}
+
+// Compile a reference to a column of a source table (e.g., 'x.b').
+// Returns -1 if t does not refer to a column of a source table.
+std::size_t
+Filter::compile_column(Mem* t) {
+  Ref* table = as<Ref>(t->record());
+  Ref* member = as<Ref>(t->member());
+  if (not table or not member)
+    return -1;
+  Var* v = as<Var>(member->decl());
+  for (std::size_t i = 0; i < sources.size(); ++i) {
+    if (sources[i].def != table->decl())
+      continue;
+    Term_seq* vars = get_table_type(sources[i].table)->members();
+    for (std::size_t j = 0; j < vars->size(); ++j) {
+      if (is_same(v->name(), as<Var>((*vars)[j])->name())) {
+        Node n {column_op, get_bool_cell(false), i, j, 0, 0, t};
+        return add(n);
+      }
+    }
+  }
+  return -1;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Filter evaluation
+
+// Evaluate the node n for the given rows of the source tables. The
+// kth row is a row of the kth source.
+Cell
+Filter::eval(std::size_t n, const std::size_t* rows) const {
+  const Node& node = nodes[n];
+  switch (node.op) {
+  case const_op:
+    return node.value;
+  case column_op: {
+    const Filter_source& s = sources[node.source];
+    return get_cell(*s.table->column(node.column), rows[s.input]);
+  }
+  case eq_op:
+    return get_bool_cell(is_same(eval(node.n1, rows), eval(node.n2, rows)));
+  case less_op:
+    return get_bool_cell(is_less(eval(node.n1, rows), eval(node.n2, rows)));
+  case and_op: {
+    bool b1 = is_true(eval(node.n1, rows));
+    bool b2 = is_true(eval(node.n2, rows));
+    return get_bool_cell(b1 and b2);
+  }
+  case or_op: {
+    bool b1 = is_true(eval(node.n1, rows));
+    bool b2 = is_true(eval(node.n2, rows));
+    return get_bool_cell(b1 or b2);
+  }
+  case not_op:
+    return get_bool_cell(not is_true(eval(node.n1, rows)));
+  case term_op: {
+    Subst sub;
+    for (std::size_t i = 0; i < sources.size(); ++i)
+      if (sources[i].def)
+        sub.insert({sources[i].def, get_row(sources[i].table, rows[sources[i].input])});
+    return get_cell(::eval(subst_term(node.term, sub)));
+  }
+  }
+  lang_unreachable("unknown filter operation");
+}
+
+// Returns true when the condition holds for the given rows of the
+// source tables.
+bool
+Filter::test(const std::size_t* rows) const {
+  return is_true(eval(root, rows));
+}
+
+// Returns the kind of value computed by the node n. Comparisons and
+// logical operators compute booleans; a term computes any value.
+Column_kind
+Filter::get_kind(std::size_t n) const {
+  const Node& node = nodes[n];
+  switch (node.op) {
+  case const_op:
+    return node.value.kind;
+  case column_op:
+    return sources[node.source].table->column(node.column)->kind;
+  case term_op:
+    return term_column;
+  default:
+    return bool_column;
+  }
+}
+
+// Returns true when the node n does not evaluate any term for each
+// row. Such nodes have no effects and need not be evaluated for rows
+// that are already rejected.
+bool
+Filter::is_pure(std::size_t n) const {
+  const Node& node = nodes[n];
+  switch (node.op) {
+  case const_op:
+  case column_op:
+    return true;
+  case eq_op:
+  case less_op:
+  case and_op:
+  case or_op:
+    return is_pure(node.n1) and is_pure(node.n2);
+  case not_op:
+    return is_pure(node.n1);
+  case term_op:
+    return false;
+  }
+  lang_unreachable("unknown filter operation");
+}
+
+// Returns, for each node, whether it can be evaluated by batch over
+// boolean and natural number columns. Operands are compiled before
+// the nodes that use them, so a single pass suffices.
+std::vector<char>
+Filter::get_vectors() const {
+  std::vector<char> vec(nodes.size());
+  for (std::size_t n = 0; n < nodes.size(); ++n) {
+    const Node& node = nodes[n];
+    Column_kind k = get_kind(n);
+    switch (node.op) {
+    case const_op:
+    case column_op:
+      vec[n] = k == bool_column or k == nat_column;
+      break;
+    case eq_op:
+      vec[n] = vec[node.n1] and vec[node.n2] and get_kind(node.n1) == get_kind(node.n2);
+      break;
+    case less_op:
+      vec[n] = vec[node.n1] and vec[node.n2]
+           and get_kind(node.n1) == nat_column and get_kind(node.n2) == nat_column;
+      break;
+    case and_op:
+    case or_op:
+      vec[n] = vec[node.n1] and vec[node.n2];
+      break;
+    case not_op:
+      vec[n] = vec[node.n1];
+      break;
+    case term_op:
+      vec[n] = false;
+      break;
+    }
+  }
+  return vec;
+}
+
+namespace {
+
+// The number of rows evaluated in each batch.
+constexpr std::size_t batch_size = 1024;
+
+// Compare the natural numbers of the nodes a and b for count rows
+// starting at first, writing the results to out. Each operand is
+// either a column or a value.
+template<typename Cmp>
+  void
+  compare_nats(const Filter& f, const Filter::Node& a, const Filter::Node& b,
+               std::size_t first, std::size_t count, std::uint8_t* out, Cmp cmp) {
+    const unsigned long* p = nullptr;
+    const unsigned long* q = nullptr;
+    if (a.op == Filter::column_op)
+      p = f.sources[a.source].table->column(a.column)->nats.data() + first;
+    if (b.op == Filter::column_op)
+      q = f.sources[b.source].table->column(b.column)->nats.data() + first;
+    unsigned long x = a.value.nat;
+    unsigned long y = b.value.nat;
+    if (p and q) {
+      for (std::size_t i = 0; i < count; ++i)
+        out[i] = cmp(p[i], q[i]);
+    } else if (p) {
+      for (std::size_t i = 0; i < count; ++i)
+        out[i] = cmp(p[i], y);
+    } else if (q) {
+      for (std::size_t i = 0; i < count; ++i)
+        out[i] = cmp(x, q[i]);
+    } else {
+      std::fill(out, out + count, cmp(x, y));
+    }
+  }
+
+} // namespace
+
+// Evaluate the boolean node n for count rows starting at first. The
+// results of each boolean node are stored in bits, one batch per
+// node, and operands must be evaluated before the nodes using them.
+void
+Filter::eval_batch(std::size_t n, std::size_t first, std::size_t count, std::uint8_t* bits) const {
+  const Node& node = nodes[n];
+  std::uint8_t* out = bits + n * batch_size;
+  const std::uint8_t* a = bits + node.n1 * batch_size;
+  const std::uint8_t* b = bits + node.n2 * batch_size;
+  switch (node.op) {
+  case const_op:
+    std::fill(out, out + count, node.value.nat);
+    return;
+  case column_op: {
+    const std::uint8_t* p = sources[node.source].table->column(node.column)->bools.data();
+    std::copy(p + first, p + first + count, out);
+    return;
+  }
+  case eq_op:
+    if (get_kind(node.n1) == nat_column) {
+      auto eq = [](unsigned long x, unsigned long y) { return x == y; };
+      compare_nats(*this, nodes[node.n1], nodes[node.n2], first, count, out, eq);
+    } else {
+      for (std::size_t i = 0; i < count; ++i)
+        out[i] = a[i] == b[i];
+    }
+    return;
+  case less_op: {
+    auto lt = [](unsigned long x, unsigned long y) { return x < y; };
+    compare_nats(*this, nodes[node.n1], nodes[node.n2], first, count, out, lt);
+    return;
+  }
+  case and_op:
+    for (std::size_t i = 0; i < count; ++i)
+      out[i] = a[i] & b[i];
+    return;
+  case or_op:
+    for (std::size_t i = 0; i < count; ++i)
+      out[i] = a[i] | b[i];
+    return;
+  case not_op:
+    for (std::size_t i = 0; i < count; ++i)
+      out[i] = a[i] ^ 1;
+    return;
+  case term_op:
+    break;
+  }
+  lang_unreachable("evaluating a term by batch");
+}
+
+// Select the rows of the table satisfying the condition by testing
+// each row in turn.
+std::vector<std::size_t>
+Filter::select_rows() const {
+  Table* table = sources.front().table;
+  std::vector<std::size_t> rows;
+  for (std::size_t i = 0; i < table->rows(); ++i)
+    if (test(&i))
+      rows.push_back(i);
+  return rows;
+}
+
+// Select the rows of the table for which all of the conditions vs
+// hold, evaluating them by batch, and then all of the conditions rs
+// hold, testing them for each of the remaining rows.
+std::vector<std::size_t>
+Filter::select_columns(const std::vector<std::size_t>& vs,
+                       const std::vector<std::size_t>& rs) const {
+  Table* table = sources.front().table;
+  std::vector<char> vec = get_vectors();
+  std::vector<std::uint8_t> bits(nodes.size() * batch_size);
+  std::vector<std::uint8_t> keep(batch_size);
+  std::vector<std::size_t> rows;
+  for (std::size_t first = 0; first < table->rows(); first += batch_size) {
+    std::size_t count = std::min(batch_size, table->rows() - first);
+
+    // Evaluate every boolean node that can be evaluated by batch.
+    for (std::size_t n = 0; n < nodes.size(); ++n)
+      if (vec[n] and get_kind(n) == bool_column)
+        eval_batch(n, first, count, bits.data());
+
+    std::fill(keep.begin(), keep.begin() + count, 1);
+    for (std::size_t n : vs) {
+      const std::uint8_t* b = bits.data() + n * batch_size;
+      for (std::size_t i = 0; i < count; ++i)
+        keep[i] &= b[i];
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      if (not keep[i])
+        continue;
+      std::size_t row = first + i;
+      bool ok = true;
+      for (std::size_t n : rs)
+        if (not is_true(eval(n, &row))) {
+          ok = false;
+          break;
+        }
+      if (ok)
+        rows.push_back(row);
+    }
+  }
+  return rows;
+}
+
+// Returns the selection vector of a filter over a single table: the
+// indexes of the rows for which the condition holds, in order.
+//
+// The conjuncts of the condition that can be evaluated by batch are
+// evaluated first. The others are tested only for the rows satisfying
+// those, unless they evaluate terms, in which case every row is
+// tested as a whole.
+std::vector<std::size_t>
+Filter::select() const {
+  for (const Filter_source& s : sources)
+    lang_assert(s.input == 0, "selection from multiple tables");
+
+  // Split the condition into its conjuncts.
+  std::vector<std::size_t> conds {root};
+  for (std::size_t i = 0; i < conds.size(); ) {
+    const Node& node = nodes[conds[i]];
+    if (node.op == and_op) {
+      conds[i] = node.n1;
+      conds.push_back(node.n2);
+    } else {
+      ++i;
+    }
+  }
+
+  std::vector<char> vec = get_vectors();
+  std::vector<std::size_t> vs;
+  std::vector<std::size_t> rs;
+  for (std::size_t n : conds) {
+    if (vec[n] and get_kind(n) == bool_column)
+      vs.push_back(n);
+    else if (is_pure(n))
+      rs.push_back(n);
+    else
+      return select_rows();
+  }
+  if (vs.empty())
+    return select_rows();
+  return select_columns(vs, rs);
+}
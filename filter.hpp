@@ -0,0 +1,98 @@
+
+#ifndef FILTER_HPP
+#define FILTER_HPP
+
+#include "table.hpp"
+
+// This module compiles the conditions of queries into filters over
+// the rows of tables. A filter is compiled once per query and then
+// tested against each row, without substituting the row into the
+// condition.
+
+// -------------------------------------------------------------------------- //
+// Filters
+
+// A table whose rows are referred to by a definition in a condition.
+// For example, in 'select x.a from x where x.b eq 1', the condition
+// refers to the rows of the table 'x' through its definition.
+//
+// The rows tested by a filter are given by index, one per input.
+// Several sources may share an input when they are the columns of
+// different tables in the result of a join.
+struct Filter_source {
+  Def* def;
+  Table* table;
+  std::size_t input;
+};
+
+// A single value computed by a filter. The value is stored in the
+// same representation as a column value of the given kind.
+struct Cell {
+  Column_kind kind;
+  unsigned long nat;
+  String str;
+  Term* term;
+};
+
+// A condition compiled against the columns of its source tables.
+//
+// References to the columns of a source table (e.g., 'x.b') read the
+// value directly from the column. Subterms that do not refer to any
+// source table are evaluated once, when the filter is compiled. Any
+// other subterm is evaluated for each row by substituting the rows of
+// the source tables into it.
+//
+// When selecting from a single table, comparisons, conjunctions,
+// disjunctions, and negations of boolean and natural number columns
+// and values are evaluated a batch of rows at a time, in loops over
+// the column arrays. The remaining parts of the condition are tested
+// row by row, only for the rows selected by those loops.
+struct Filter {
+  // The kinds of operations in a compiled condition.
+  enum Op {
+    const_op,  // A value
+    column_op, // A column of a source table
+    eq_op,     // n1 eq n2
+    less_op,   // n1 lt n2
+    and_op,    // n1 and n2
+    or_op,     // n1 or n2
+    not_op,    // not n1
+    term_op,   // A term evaluated for each row
+  };
+
+  // A node of the compiled condition. Operands are the indexes of
+  // other nodes.
+  struct Node {
+    Op op;
+    Cell value;
+    std::size_t source;
+    std::size_t column;
+    std::size_t n1;
+    std::size_t n2;
+    Term* term;
+  };
+
+  Filter(Term*, const std::vector<Filter_source>&);
+
+  bool test(const std::size_t*) const;
+  std::vector<std::size_t> select() const;
+
+  std::size_t compile(Term*);
+  std::size_t compile_column(Mem*);
+  std::size_t add(const Node&);
+  Cell eval(std::size_t, const std::size_t*) const;
+
+  Column_kind get_kind(std::size_t) const;
+  bool is_pure(std::size_t) const;
+  std::vector<char> get_vectors() const;
+  void eval_batch(std::size_t, std::size_t, std::size_t, std::uint8_t*) const;
+  std::vector<std::size_t> select_rows() const;
+  std::vector<std::size_t> select_columns(const std::vector<std::size_t>&,
+                                          const std::vector<std::size_t>&) const;
+
+  std::vector<Filter_source> sources;
+  std::vector<Node> nodes;
+  std::size_t root;
+};
+
+#endif
@@ -0,0 +1,319 @@
+#include "fold.hpp"
+#include "type.hpp"
+#include "value.hpp"
+#include "subst.hpp"
+
+#include "lang/debug.hpp"
+
+// -------------------------------------------------------------------------- //
+// Folding
+//
+// The following functions compute the folding of a term t. Subterms
+// are folded first, and a term whose subterms are constants is
+// replaced by its value, following the evaluation rules. Folding only
+// rewrites the terms of the core language. Other terms (e.g., lists,
+// records, and queries) are left as they are, since they are read by
+// the query planner.
+
+namespace {
+
+// The largest number of terms in the body of a function that is
+// inlined into its callers.
+constexpr int inline_limit = 32;
+
+// Returns true when t is a constant: a unit, boolean, integer, or
+// string value.
+bool
+is_constant(Term* t) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Returns a boolean constant with the value b.
+inline Term*
+make_bool(bool b) { return b ? get_true() : get_false(); }
+
+// Adds the number of terms in t to n, and returns true when every
+// term in t can be folded. A function whose body has other terms is
+// not inlined.
+bool
+count_terms(Term* t, int& n) {
+  ++n;
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case ref_term:
+    return true;
+  case if_term: {
+    If* t0 = as<If>(t);
+    return count_terms(t0->t1, n)
+       and count_terms(t0->t2, n)
+       and count_terms(t0->t3, n);
+  }
+  case succ_term: return count_terms(as<Succ>(t)->t1, n);
+  case pred_term: return count_terms(as<Pred>(t)->t1, n);
+  case iszero_term: return count_terms(as<Iszero>(t)->t1, n);
+  case not_term: return count_terms(as<Not>(t)->t1, n);
+  case and_term: return count_terms(as<And>(t)->t1, n) and count_terms(as<And>(t)->t2, n);
+  case or_term: return count_terms(as<Or>(t)->t1, n) and count_terms(as<Or>(t)->t2, n);
+  case equals_term: return count_terms(as<Equals>(t)->t1, n) and count_terms(as<Equals>(t)->t2, n);
+  case less_term: return count_terms(as<Less>(t)->t1, n) and count_terms(as<Less>(t)->t2, n);
+  case app_term: return count_terms(as<App>(t)->t1, n) and count_terms(as<App>(t)->t2, n);
+  case call_term: {
+    Call* t0 = as<Call>(t);
+    if (not count_terms(t0->fn(), n))
+      return false;
+    for (Term* a : *t0->args())
+      if (not count_terms(a, n))
+        return false;
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+// Returns the function bound to the definition referred to by t. When
+// t does not refer to a function, when the function is too large to be
+// inlined, or when its body cannot be folded, returns nullptr.
+//
+// Only functions bound by definitions are inlined. These are closed,
+// so their bodies refer to no parameters of enclosing functions, and
+// can be moved into another function.
+Term*
+get_inline_fn(Term* t) {
+  Ref* r = as<Ref>(t);
+  if (not r)
+    return nullptr;
+  Def* d = as<Def>(r->decl());
+  if (not d)
+    return nullptr;
+  Term* fn = as<Term>(d->value());
+  Term* body;
+  if (Abs* abs = as<Abs>(fn))
+    body = abs->term();
+  else if (Fn* f = as<Fn>(fn))
+    body = f->term();
+  else
+    return nullptr;
+  int n = 0;
+  if (count_terms(body, n) and n <= inline_limit)
+    return fn;
+  return nullptr;
+}
+
+// Fold a reference. A reference to a definition whose value is a
+// constant is replaced by that constant.
+Term*
+fold_ref(Ref* t) {
+  if (Def* d = as<Def>(t->decl()))
+    if (Term* v = as<Term>(d->value()))
+      if (is_constant(v))
+        return v;
+  return t;
+}
+
+// Fold an if term. When the condition is a constant, the term is
+// replaced by the selected branch.
+//
+//    if true then t2 else t3 => t2
+//    if false then t2 else t3 => t3
+Term*
+fold_if(If* t) {
+  Term* t1 = fold(t->cond());
+  if (is_true(t1))
+    return fold(t->if_true());
+  if (is_false(t1))
+    return fold(t->if_false());
+  return new If(t->loc, get_type(t), t1, fold(t->if_true()), fold(t->if_false()));
+}
+
+// Fold 'succ t', 'pred t', and 'iszero t'. When the operand is an
+// integer n, these are replaced by n + 1, n - 1 (or 0), and whether
+// n is 0.
+Term*
+fold_succ(Succ* t) {
+  Term* t1 = fold(t->arg());
+  if (Int* n = as<Int>(t1))
+    return get_int(n->value() + Integer(1l));
+  return new Succ(t->loc, get_type(t), t1);
+}
+
+Term*
+fold_pred(Pred* t) {
+  Term* t1 = fold(t->arg());
+  if (Int* n = as<Int>(t1)) {
+    if (n->value() == 0)
+      return n;
+    return get_int(n->value() - Integer(1l));
+  }
+  return new Pred(t->loc, get_type(t), t1);
+}
+
+Term*
+fold_iszero(Iszero* t) {
+  Term* t1 = fold(t->arg());
+  if (Int* n = as<Int>(t1))
+    return make_bool(n->value() == 0);
+  return new Iszero(t->loc, get_type(t), t1);
+}
+
+// Fold the boolean operators and comparisons. When every operand is a
+// constant, the term is replaced by its value.
+Term*
+fold_and(And* t) {
+  Term* t1 = fold(t->t1);
+  Term* t2 = fold(t->t2);
+  if (is_constant(t1) and is_constant(t2))
+    return make_bool(is_true(t1) and is_true(t2));
+  return new And(t->loc, get_type(t), t1, t2);
+}
+
+Term*
+fold_or(Or* t) {
+  Term* t1 = fold(t->t1);
+  Term* t2 = fold(t->t2);
+  if (is_constant(t1) and is_constant(t2))
+    return make_bool(is_true(t1) or is_true(t2));
+  return new Or(t->loc, get_type(t), t1, t2);
+}
+
+Term*
+fold_not(Not* t) {
+  Term* t1 = fold(t->t1);
+  if (is_constant(t1))
+    return make_bool(is_false(t1));
+  return new Not(t->loc, get_type(t), t1);
+}
+
+Term*
+fold_equals(Equals* t) {
+  Term* t1 = fold(t->t1);
+  Term* t2 = fold(t->t2);
+  if (is_constant(t1) and is_constant(t2))
+    return make_bool(is_same(t1, t2));
+  return new Equals(t->loc, get_type(t), t1, t2);
+}
+
+Term*
+fold_less(Less* t) {
+  Term* t1 = fold(t->t1);
+  Term* t2 = fold(t->t2);
+  if (is_constant(t1) and is_constant(t2))
+    return make_bool(is_less(t1, t2));
+  return new Less(t->loc, get_type(t), t1, t2);
+}
+
+// Fold the body of a function.
+Term*
+fold_abs(Abs* t) {
+  return new Abs(t->loc, get_type(t), t->var(), fold(t->term()));
+}
+
+Term*
+fold_fn(Fn* t) {
+  return new Fn(t->loc, get_type(t), t->parms(), fold(t->term()));
+}
+
+// Fold an application. When a small function bound by a definition
+// is applied to a constant, the application is replaced by the
+// folding of its beta reduction.
+//
+//    (\x:T.t) c => fold([x->c]t)
+//
+// Definitions cannot refer to themselves, so inlining terminates.
+Term*
+fold_app(App* t) {
+  Term* t1 = fold(t->abs());
+  Term* t2 = fold(t->arg());
+  if (is_constant(t2)) {
+    if (Abs* fn = as<Abs>(get_inline_fn(t1))) {
+      Subst sub {fn->var(), t2};
+      return fold(subst_term(fn->term(), sub));
+    }
+  }
+  return new App(t->loc, get_type(t), t1, t2);
+}
+
+// Fold a function call. As with applications, a call of a small
+// defined function on constants is replaced by the folding of its body.
+Term*
+fold_call(Call* t) {
+  Term* t1 = fold(t->fn());
+  Term_seq* args = new Term_seq();
+  bool constant = true;
+  for (Term* a : *t->args()) {
+    args->push_back(fold(a));
+    constant = constant and is_constant(args->back());
+  }
+  if (constant) {
+    if (Fn* fn = as<Fn>(get_inline_fn(t1))) {
+      Subst sub {fn->parms(), args};
+      return fold(subst_term(fn->term(), sub));
+    }
+  }
+  return new Call(t->loc, get_type(t), t1, args);
+}
+
+// Fold the value of a definition. The value is replaced in place,
+// since later terms refer to the definition.
+Term*
+fold_def(Def* t) {
+  if (Term* t0 = as<Term>(t->value()))
+    t->t2 = fold(t0);
+  return t;
+}
+
+Term*
+fold_print(Print* t) {
+  if (Term* t0 = as<Term>(t->expr()))
+    return new Print(t->loc, get_type(t), fold(t0));
+  return t;
+}
+
+// Fold each statement of a program in turn.
+Term*
+fold_prog(Prog* t) {
+  Term_seq* ss = new Term_seq();
+  for (Term* s : *t->stmts())
+    ss->push_back(fold(s));
+  return new Prog(get_type(t), ss);
+}
+
+} // namespace
+
+// Returns the term t with its constant subterms folded.
+Term*
+fold(Term* t) {
+  switch (t->kind) {
+  case ref_term: return fold_ref(as<Ref>(t));
+  case if_term: return fold_if(as<If>(t));
+  case succ_term: return fold_succ(as<Succ>(t));
+  case pred_term: return fold_pred(as<Pred>(t));
+  case iszero_term: return fold_iszero(as<Iszero>(t));
+  case and_term: return fold_and(as<And>(t));
+  case or_term: return fold_or(as<Or>(t));
+  case not_term: return fold_not(as<Not>(t));
+  case equals_term: return fold_equals(as<Equals>(t));
+  case less_term: return fold_less(as<Less>(t));
+  case abs_term: return fold_abs(as<Abs>(t));
+  case fn_term: return fold_fn(as<Fn>(t));
+  case app_term: return fold_app(as<App>(t));
+  case call_term: return fold_call(as<Call>(t));
+  case def_term: return fold_def(as<Def>(t));
+  case print_term: return fold_print(as<Print>(t));
+  case prog_term: return fold_prog(as<Prog>(t));
+  default: return t;
+  }
+}
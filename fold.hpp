@@ -0,0 +1,16 @@
+
+#ifndef FOLD_HPP
+#define FOLD_HPP
+
+#include "ast.hpp"
+
+// This module defines a partial evaluator that runs between
+// elaboration and evaluation. Closed subterms whose value is known
+// before the program runs (e.g., 'succ 3' or 'if true then t2 else t3')
+// are replaced by their values, and small functions bound by
+// definitions are inlined when applied to constants. The remaining
+// terms are left as residual code, to be evaluated at run time.
+
+Term* fold(Term*);
+
+#endif
@@ -0,0 +1,209 @@
+#include "group.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include "lang/debug.hpp"
+
+#include <algorithm>
+#include <climits>
+
+// -------------------------------------------------------------------------- //
+// Accumulators
+
+namespace {
+
+// Returns true when the values of the column c are stored in words.
+inline bool
+is_word(const Column& c) {
+  return c.kind == nat_column or c.kind == bool_column;
+}
+
+// Returns the nth value of the column c as a word.
+inline unsigned long
+get_word(const Column& c, std::size_t n) {
+  return c.kind == nat_column ? c.nats[n] : c.bools[n];
+}
+
+} // namespace
+
+// Start a new group whose first row is the nth row of c.
+void
+Accumulator::add_group(const Column& c, std::size_t n) {
+  if (op == count_agg) {
+    words.push_back(1);
+    return;
+  }
+  if (not boxed and is_word(c)) {
+    words.push_back(get_word(c, n));
+    return;
+  }
+  box();
+  terms.push_back(c.get(n));
+}
+
+// Add the nth row of c to the group g.
+void
+Accumulator::add(std::size_t g, const Column& c, std::size_t n) {
+  switch (op) {
+  case count_agg:
+    ++words[g];
+    return;
+
+  case sum_agg:
+    // Both operands fit in a signed word, so their sum cannot wrap.
+    if (not boxed and c.kind == nat_column) {
+      unsigned long r = words[g] + c.nats[n];
+      if (r <= LONG_MAX) {
+        words[g] = r;
+        return;
+      }
+    }
+    box();
+    {
+      Integer z = as<Int>(terms[g])->value();
+      z += as<Int>(c.get(n))->value();
+      terms[g] = get_int(z);
+    }
+    return;
+
+  case min_agg:
+  case max_agg:
+    if (not boxed and is_word(c)) {
+      unsigned long x = get_word(c, n);
+      words[g] = op == min_agg ? std::min(words[g], x) : std::max(words[g], x);
+      return;
+    }
+    box();
+    {
+      Term* v = c.get(n);
+      if (op == min_agg ? is_less(v, terms[g]) : is_less(terms[g], v))
+        terms[g] = v;
+    }
+    return;
+  }
+  lang_unreachable("unknown aggregate");
+}
+
+// Store the values of every group as terms.
+void
+Accumulator::box() {
+  if (boxed)
+    return;
+  terms.reserve(words.size());
+  for (unsigned long w : words) {
+    if (kind == bool_column)
+      terms.push_back(w ? get_true() : get_false());
+    else
+      terms.push_back(get_int(w));
+  }
+  words.clear();
+  words.shrink_to_fit();
+  boxed = true;
+}
+
+// Returns the column of values of the aggregate, one per group.
+Column*
+Accumulator::get_column() const {
+  Column* c = new_in_arena<Column>(kind);
+  if (boxed) {
+    c->reserve(terms.size());
+    for (Term* t : terms)
+      c->push_back(t);
+  } else if (kind == bool_column) {
+    c->bools.assign(words.begin(), words.end());
+  } else {
+    c->nats = words;
+  }
+  return c;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Groupings
+
+// Create an empty grouping whose result has the given type. The
+// columns of the result correspond to the items.
+Grouping::Grouping(Type* t, const std::vector<Group_item>& is)
+  : type(t), items(is), keys(make_table(t, 0)) {
+  for (std::size_t i = 0; i < items.size(); ++i)
+    if (not items[i].key)
+      accs.emplace_back(items[i].op, keys->column(i)->kind);
+}
+
+namespace {
+
+// Returns the hash code of the keys of the nth row of t.
+std::size_t
+hash_keys(const std::vector<Group_item>& items, Table* t, std::size_t n) {
+  std::size_t h = 0;
+  for (const Group_item& i : items)
+    if (i.key)
+      h = hash_combine(h, hash(*t->column(i.column), n));
+  return h;
+}
+
+} // namespace
+
+// Returns the group of the nth row of t, or -1 if no group has the
+// keys of that row.
+std::size_t
+Grouping::find_group(Table* t, std::size_t n) const {
+  auto iter = index.find(hash_keys(items, t, n));
+  if (iter == index.end())
+    return -1;
+  for (std::size_t g : iter->second) {
+    bool same = true;
+    for (std::size_t i = 0; i < items.size() and same; ++i)
+      if (items[i].key)
+        same = is_same(*t->column(items[i].column), n, *keys->column(i), g);
+    if (same)
+      return g;
+  }
+  return -1;
+}
+
+// Add a group whose first row is the nth row of t.
+void
+Grouping::add_group(Table* t, std::size_t n) {
+  index[hash_keys(items, t, n)].push_back(count++);
+  std::size_t a = 0;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    const Column& c = *t->column(items[i].column);
+    if (items[i].key)
+      keys->column(i)->push_back(c, n);
+    else
+      accs[a++].add_group(c, n);
+  }
+}
+
+// Add the rows of t to their groups.
+void
+Grouping::add(Table* t) {
+  for (std::size_t n = 0; n < t->rows(); ++n) {
+    std::size_t g = find_group(t, n);
+    if (g == std::size_t(-1)) {
+      add_group(t, n);
+      continue;
+    }
+    std::size_t a = 0;
+    for (const Group_item& i : items)
+      if (not i.key)
+        accs[a++].add(g, *t->column(i.column), n);
+  }
+}
+
+// Returns a table with a row for each group, listing its keys and its
+// aggregates.
+Table*
+Grouping::result() const {
+  Column_seq* cs = new_in_arena<Column_seq>();
+  cs->reserve(items.size());
+  std::size_t a = 0;
+  for (std::size_t i = 0; i < items.size(); ++i) {
+    if (items[i].key)
+      cs->push_back(keys->column(i));
+    else
+      cs->push_back(accs[a++].get_column());
+  }
+  return new Table(type, cs);
+}
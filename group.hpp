@@ -0,0 +1,66 @@
+
+#ifndef GROUP_HPP
+#define GROUP_HPP
+
+#include "table.hpp"
+
+// This module computes groupings of the rows of tables and the
+// aggregates of each group. Rows are grouped by hashing the values of
+// their key columns, and aggregates are accumulated directly from the
+// columns of each batch of rows, without constructing terms for their
+// values.
+
+// -------------------------------------------------------------------------- //
+// Groupings
+
+// An element of a grouping: either a key column or an aggregate of a
+// column of the grouped rows. Columns are given by index.
+struct Group_item {
+  bool key;
+  Aggregate_op op;
+  std::size_t column;
+};
+
+// The values of an aggregate for each group.
+//
+// Counts, and the sums, least, and greatest values of natural number
+// and boolean columns, are accumulated in machine words. When a sum
+// no longer fits in a word, or when the values of the column are not
+// stored in words, the values of every group are stored as terms.
+struct Accumulator {
+  Accumulator(Aggregate_op op, Column_kind k)
+    : op(op), kind(k) { }
+
+  void add_group(const Column&, std::size_t);
+  void add(std::size_t, const Column&, std::size_t);
+  void box();
+  Column* get_column() const;
+
+  Aggregate_op op;
+  Column_kind kind;
+  bool boxed = false;
+  std::vector<unsigned long> words;
+  std::vector<Term*> terms;
+};
+
+// A grouping of rows by the values of their key columns. Rows are
+// added a batch at a time. Groups are numbered in the order their
+// first row is added, and the result lists them in that order.
+struct Grouping {
+  Grouping(Type*, const std::vector<Group_item>&);
+
+  void add(Table*);
+  Table* result() const;
+
+  std::size_t find_group(Table*, std::size_t) const;
+  void add_group(Table*, std::size_t);
+
+  Type* type;
+  std::vector<Group_item> items;
+  Table* keys;
+  std::vector<Accumulator> accs;
+  std::unordered_map<std::size_t, std::vector<std::size_t>> index;
+  std::size_t count = 0;
+};
+
+#endif
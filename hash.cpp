@@ -0,0 +1,112 @@
+#include "ast.hpp"
+#include "table.hpp"
+
+#include "lang/debug.hpp"
+
+#include <functional>
+
+// -------------------------------------------------------------------------- //
+// Hashing
+//
+// The hash function computes a hash code for value terms. The hash is
+// consistent with the same-term relation: when is_same(a, b) holds,
+// hash(a) == hash(b).
+
+// Mix the hash code h into the seed.
+std::size_t
+hash_combine(std::size_t seed, std::size_t h) {
+  return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+namespace {
+
+// Hash the limbs of an integer value that does not fit in a word.
+std::size_t
+hash_value(const Integer& n) {
+  const mpz_t& z = n.data();
+  std::size_t h = std::hash<int>()(mpz_sgn(z));
+  for (std::size_t i = 0; i < mpz_size(z); ++i)
+    h = hash_combine(h, mpz_getlimbn(z, i));
+  return h;
+}
+
+// Hash an integer term.
+std::size_t
+hash_integer(Int* t) {
+  const mpz_t& z = t->value().data();
+  if (mpz_fits_ulong_p(z))
+    return hash_int(mpz_get_ui(z));
+  std::size_t h = std::hash<Node_kind>()(int_term);
+  return hash_combine(h, hash_value(t->value()));
+}
+
+// Hash the name and value of an initializer.
+std::size_t
+hash_init(Init* t) {
+  return hash_combine(hash(t->name()), hash(t->value()));
+}
+
+// Hash each member of a record in order.
+std::size_t
+hash_record(Record* t) {
+  std::size_t h = 0;
+  for (Term* m : *t->members())
+    h = hash_combine(h, hash(m));
+  return h;
+}
+
+// Hash each element of a sequence in order.
+std::size_t
+hash_seq(Term_seq* ts) {
+  std::size_t h = 0;
+  for (Term* t : *ts)
+    h = hash_combine(h, hash(t));
+  return h;
+}
+
+// Hash each row of a table in order.
+std::size_t
+hash_table(Table* t) {
+  std::size_t h = std::hash<std::size_t>()(t->rows());
+  for (std::size_t i = 0; i < t->rows(); ++i)
+    h = hash_combine(h, hash_row(t, i));
+  return h;
+}
+
+} // namespace
+
+// Returns the hash code of an integer term whose value is n. This
+// allows integers stored outside of terms to be hashed consistently
+// with integer terms.
+std::size_t
+hash_int(unsigned long n) {
+  std::size_t h = std::hash<Node_kind>()(int_term);
+  return hash_combine(h, std::hash<unsigned long>()(n));
+}
+
+// Returns the hash code of a string term whose value is s.
+std::size_t
+hash_str(String s) {
+  std::size_t h = std::hash<Node_kind>()(str_term);
+  return hash_combine(h, std::hash<String>()(s));
+}
+
+std::size_t
+hash(Expr* e) {
+  std::size_t h = std::hash<Node_kind>()(e->kind);
+  switch (e->kind) {
+  case id_expr: return hash_combine(h, std::hash<String>()(as<Id>(e)->t1));
+  case unit_term: return h;
+  case true_term: return h;
+  case false_term: return h;
+  case int_term: return hash_integer(as<Int>(e));
+  case str_term: return hash_str(as<Str>(e)->value());
+  case init_term: return hash_combine(h, hash_init(as<Init>(e)));
+  case record_term: return hash_combine(h, hash_record(as<Record>(e)));
+  case tuple_term: return hash_combine(h, hash_seq(as<Tuple>(e)->elems()));
+  case list_term: return hash_combine(h, hash_seq(as<List>(e)->elems()));
+  case table_term: return hash_combine(h, hash_table(as<Table>(e)));
+  default: break;
+  }
+  lang_unreachable(format("hashing unhashable term '{}'", node_name(e)));
+}
@@ -0,0 +1,85 @@
+#include "arena.hpp"
+
+#include <new>
+
+namespace {
+
+// The size of the blocks of an arena. Allocations larger than a
+// quarter of a block get their own block.
+constexpr std::size_t block_size = 64 * 1024;
+
+// The alignment of every allocation. Nodes and the elements of
+// sequences hold only pointers and integers.
+constexpr std::size_t block_align = alignof(void*);
+
+// The current arena of each thread.
+thread_local Arena* current_arena_ = nullptr;
+
+// Returns n rounded up to the alignment of allocations.
+inline std::size_t
+align(std::size_t n) {
+  return (n + block_align - 1) & ~(block_align - 1);
+}
+
+} // namespace
+
+// Returns n bytes of memory. The memory is released with the arena.
+void*
+Arena::allocate(std::size_t n) {
+  n = align(n);
+  if (n > block_size / 4) {
+    char* p = static_cast<char*>(::operator new(n));
+    blocks.push_back(p);
+    return p;
+  }
+  if (static_cast<std::size_t>(last - next) < n) {
+    next = static_cast<char*>(::operator new(block_size));
+    last = next + block_size;
+    blocks.push_back(next);
+  }
+  char* p = next;
+  next += n;
+  return p;
+}
+
+// Call f on p when the arena is released.
+void
+Arena::finalize(void* p, Finalizer f) {
+  finalizers.emplace_back(p, f);
+}
+
+// Move the memory and finalizers of the arena a into this arena. The
+// arena a is left empty.
+void
+Arena::adopt(Arena& a) {
+  blocks.insert(blocks.end(), a.blocks.begin(), a.blocks.end());
+  finalizers.insert(finalizers.end(), a.finalizers.begin(), a.finalizers.end());
+  a.blocks.clear();
+  a.finalizers.clear();
+  a.next = a.last = nullptr;
+}
+
+// Call the finalizers of the arena, in the reverse order of their
+// registration, and release its memory.
+void
+Arena::release() {
+  for (auto iter = finalizers.rbegin(); iter != finalizers.rend(); ++iter)
+    iter->second(iter->first);
+  for (char* p : blocks)
+    ::operator delete(p);
+  finalizers.clear();
+  blocks.clear();
+  next = last = nullptr;
+}
+
+// Returns the current arena of this thread, or nullptr if there is
+// none.
+Arena*
+current_arena() { return current_arena_; }
+
+Arena_guard::Arena_guard(Arena* a)
+  : outer(current_arena_) {
+  current_arena_ = a;
+}
+
+Arena_guard::~Arena_guard() { current_arena_ = outer; }
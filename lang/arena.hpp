@@ -0,0 +1,75 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------------- //
+// Arenas
+
+// An arena allocates the memory of nodes by advancing a pointer
+// through large blocks of memory. Nodes allocated in an arena are not
+// freed one at a time. Instead, all of its memory is released when the
+// arena is released.
+//
+// Nodes are allocated in the current arena of their thread (see
+// Arena_guard). When no arena is current, nodes are allocated on the
+// heap and never freed. Other memory, such as the elements of large
+// sequences, can also be allocated in an arena.
+//
+// Nodes are not destroyed with the arena. A node that owns memory
+// outside the arena (e.g., a large integer) registers a finalizer,
+// which is called when the arena is released (see destroy_in_arena).
+// Other objects of the evaluators (e.g., the columns of tables) are
+// allocated in an arena by new_in_arena.
+struct Arena {
+  using Finalizer = void (*)(void*);
+
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena() { release(); }
+
+  void* allocate(std::size_t);
+  void finalize(void*, Finalizer);
+  void adopt(Arena&);
+  void release();
+
+  std::vector<char*> blocks;
+  char* next = nullptr;
+  char* last = nullptr;
+  std::vector<std::pair<void*, Finalizer>> finalizers;
+};
+
+Arena* current_arena();
+
+// Returns a new object of type T, constructed with the arguments args,
+// in the current arena. The object is destroyed when the arena is
+// released. When no arena is current, the object is allocated on the
+// heap and never freed, as are nodes.
+template<typename T, typename... Args>
+  inline T*
+  new_in_arena(Args&&... args) {
+    Arena* a = current_arena();
+    if (not a)
+      return new T(std::forward<Args>(args)...);
+    T* t = new (a->allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    if (not std::is_trivially_destructible<T>::value)
+      a->finalize(t, [](void* p) { static_cast<T*>(p)->~T(); });
+    return t;
+  }
+
+// A helper class that makes an arena the current arena of its
+// thread, and restores the previous one when it goes out of scope.
+// When the arena is null, nodes are allocated on the heap.
+struct Arena_guard {
+  Arena_guard(Arena*);
+  ~Arena_guard();
+
+  Arena* outer;
+};
+
+#endif
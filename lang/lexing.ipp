@@ -11,7 +11,7 @@ template<typename L>
   inline void
   advance(L& lex, int n) {
     lex.first += n;
-    lex.loc.col += n;
+    lex.loc.advance(n);
   }
 
 // Save a token having the given location, symbol, and text.
@@ -72,8 +72,7 @@ template<typename L>
   inline void
   newline(L& lex) {
     ++lex.first;
-    ++lex.loc.line;
-    lex.loc.col = 1;
+    lex.loc.next_line();
   }
 
 // Consume a comment, starting with "//" and up to (but not including)
@@ -2,6 +2,7 @@
 #ifndef LOCATION_HPP
 #define LOCATION_HPP
 
+#include <cstdint>
 #include <iosfwd>
 
 // Types for special location constructors.
@@ -9,21 +10,32 @@ enum no_location_t { no_location };
 enum eof_location_t { eof_location };
 
 // A location represents a position in a source file, indicated by its
-// line and character offset.
-//
-// TODO: Ensure that we can enregister source locations.
+// line and character offset. Both are packed into a single word, with
+// the line in the high-order bits. Lines and columns past the last
+// that can be represented are clamped to it, so a long line or a large
+// file never corrupts the other field. The last line is reserved for
+// the end of file.
 //
 // TODO: Map source locations to files? 
 struct Location {
+  static constexpr int col_bits = 12;
+  static constexpr std::uint32_t col_mask = (1u << col_bits) - 1;
+  static constexpr std::uint32_t max_line = (std::uint32_t(-1) >> col_bits) - 1;
+
   Location() = default;
   Location(no_location_t);
   Location(eof_location_t);
+
+  int line() const;
+  int col() const;
+
+  void advance(int);
+  void next_line();
   
   bool is_internal() const;
   bool is_eof() const;
 
-  int line = 1;
-  int col = 1;
+  std::uint32_t pos = (1u << col_bits) | 1;
 };
 
 // Output formatting
@@ -2,18 +2,43 @@
 // Initialize an empty location.
 inline
 Location::Location(no_location_t)
-  : line(0), col(0) { }
+  : pos(0) { }
 
 // Initialize an empty location.
 inline
 Location::Location(eof_location_t)
-  : line(-1), col(0) { }
+  : pos(-1) { }
+
+inline int
+Location::line() const { return pos >> col_bits; }
+
+inline int
+Location::col() const { return pos & col_mask; }
+
+// Move the location n characters to the right. The column stops at
+// the last that can be represented.
+inline void
+Location::advance(int n) {
+  std::uint32_t c = col();
+  c = std::uint32_t(n) < col_mask - c ? c + n : col_mask;
+  pos = (pos & ~col_mask) | c;
+}
+
+// Move the location to the start of the next line. The line stops at
+// the last that can be represented.
+inline void
+Location::next_line() {
+  std::uint32_t l = line();
+  if (l < max_line)
+    ++l;
+  pos = (l << col_bits) | 1;
+}
 
 inline bool
-Location::is_internal() const { return line == 0; }
+Location::is_internal() const { return line() == 0; }
 
 inline bool
-Location::is_eof() const { return line == -1; }
+Location::is_eof() const { return pos == std::uint32_t(-1); }
 
 // Output for source locations.
 template<typename C, typename T>
@@ -23,5 +48,5 @@ template<typename C, typename T>
       return os ;
     if (loc.is_eof())
       return os << "<eof>:";
-    return os << loc.line << ':' << loc.col;
+    return os << loc.line() << ':' << loc.col();
   }
@@ -1,6 +1,7 @@
 
 #include "nodes.hpp"
 #include "debug.hpp"
+#include "arena.hpp"
 
 #include <unordered_map>
 
@@ -40,3 +41,22 @@ node_name(Node_kind k) {
 String
 node_name(Node* t) { return node_name(t->kind); }
 
+// -------------------------------------------------------------------------- //
+// Allocation
+
+// Allocate a node in the current arena, or on the heap if there is
+// no current arena.
+void*
+Node::operator new(std::size_t n) {
+  if (Arena* a = current_arena())
+    return a->allocate(n);
+  return ::operator new(n);
+}
+
+// Free the node at p, whose construction failed. If there is a current
+// arena, the node was allocated in it, and it is freed with the arena.
+void
+Node::operator delete(void* p) {
+  if (not current_arena())
+    ::operator delete(p);
+}
@@ -4,8 +4,14 @@
 
 #include "string.hpp"
 #include "location.hpp"
+#include "arena.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <new>
 
 // -------------------------------------------------------------------------- //
 // Node classification
@@ -43,6 +49,10 @@ get_node_class(Node_kind k) { return k >> 24; }
 constexpr bool
 is_util_node(Node_kind k) { return get_node_class(k) == util_class; }
 
+// Returns true if the node is a name.
+constexpr bool
+is_name_node(Node_kind k) { return get_node_class(k) == name_class; }
+
 // Returns true if the node is a type.
 constexpr bool
 is_type_node(Node_kind k) { return get_node_class(k) == type_class; }
@@ -113,31 +123,136 @@ constexpr Node_kind seq_node = make_util_node(1);
 // Nodes
 
 // The base class of all terms and types.
+//
+// Nodes are allocated in the current arena, if any (see arena.hpp).
+// They have no virtual functions, and are not destroyed when the arena
+// is released. A node class whose members must be destroyed calls
+// destroy_in_arena in its constructors.
+//
+// Every node class has a static member function has_kind that returns
+// true when a node of the given kind is an object of that class. This
+// is used to convert nodes without run-time type information (see as).
 struct Node {
   Node(Node_kind k) 
-    : loc(no_location), kind(k) { }
+    : kind(k), loc(no_location) { }
   Node(Node_kind k, const Location& loc) 
-    : loc(loc), kind(k) { }
-  virtual ~Node() { }
+    : kind(k), loc(loc) { }
+
+  static constexpr bool has_kind(Node_kind) { return true; }
+
+  static void* operator new(std::size_t);
+  static void operator delete(void*);
 
   Node_kind kind;
   Location loc;
 };
 
+// Destroy the node t when the current arena is released. Nodes on the
+// heap are never destroyed.
+template<typename T>
+  inline void
+  destroy_in_arena(T* t) {
+    if (Arena* a = current_arena())
+      a->finalize(t, [](void* p) { static_cast<T*>(p)->~T(); });
+  }
+
 
 // The Seq class provides a facility for aggregating a sequence
 // of nodes. This class also provides the same interface as
 // std::vector<T*> where T is the type of aggregated node.
 //
-// Note that T must be derived from Node.
+// Up to inline_size elements are stored in the sequence itself. The
+// elements of larger sequences are stored in the arena that was
+// current when the sequence was created, or on the heap if there was
+// none. Storage in an arena is released with the arena.
+//
+// Note that T must be derived from Node. Sequences of different node
+// types have the same kind, so they cannot be distinguished by as.
 template<typename T>
-  struct Seq : Node, std::vector<T*> {
+  struct Seq : Node {
+    using value_type = T*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T*&;
+    using const_reference = T* const&;
+    using pointer = T**;
+    using const_pointer = T* const*;
+    using iterator = T**;
+    using const_iterator = T* const*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr std::size_t inline_size = 4;
+
     Seq()
-      : Node(seq_node) { }
+      : Node(seq_node), arena(current_arena()),
+        first(local), last(local), limit(local + inline_size) { }
     Seq(std::initializer_list<T*> list)
-      : Node(seq_node), std::vector<T*>(list) { }
+      : Seq() { assign(list.begin(), list.end()); }
     Seq(std::size_t n, T* p = nullptr)
-      : Node(seq_node), std::vector<T*>(n, p) { }
+      : Seq() { assign(n, p); }
+    Seq(const Seq& s)
+      : Seq() { assign(s.begin(), s.end()); }
+    ~Seq() { free(); }
+
+    Seq& operator=(const Seq& s) {
+      if (this != &s)
+        assign(s.begin(), s.end());
+      return *this;
+    }
+
+    static constexpr bool has_kind(Node_kind k) { return k == seq_node; }
+
+    // Iterators
+    iterator begin() { return first; }
+    iterator end() { return last; }
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return last; }
+    const_iterator cbegin() const { return first; }
+    const_iterator cend() const { return last; }
+    reverse_iterator rbegin() { return reverse_iterator(last); }
+    reverse_iterator rend() { return reverse_iterator(first); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(last); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(first); }
+
+    // Capacity
+    bool empty() const { return first == last; }
+    std::size_t size() const { return last - first; }
+    std::size_t capacity() const { return limit - first; }
+    void reserve(std::size_t n) { if (n > capacity()) grow(n); }
+
+    // Element access
+    T*& operator[](std::size_t n) { return first[n]; }
+    T* operator[](std::size_t n) const { return first[n]; }
+    T*& front() { return *first; }
+    T* front() const { return *first; }
+    T*& back() { return *(last - 1); }
+    T* back() const { return *(last - 1); }
+    T** data() { return first; }
+    T* const* data() const { return first; }
+
+    // Modifiers
+    void clear() { last = first; }
+    void push_back(T* p);
+    void pop_back() { --last; }
+    void resize(std::size_t n, T* p = nullptr);
+    iterator insert(const_iterator pos, T* p);
+    template<typename I>
+      iterator insert(const_iterator pos, I a, I b);
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator a, const_iterator b);
+    void assign(std::size_t n, T* p);
+    template<typename I>
+      void assign(I a, I b);
+
+    void grow(std::size_t);
+    void free();
+
+    Arena* arena;
+    T** first;
+    T** last;
+    T** limit;
+    T* local[inline_size];
   };
 
 
@@ -1,13 +1,115 @@
 
-// Returns the node t dynamically converted to the node type U. If t does
-// not have the dynamic type U, the resulting term is null.
+// -------------------------------------------------------------------------- //
+// Sequences
+
+// Ensure that the sequence can hold at least n elements. The capacity
+// is at least doubled, so that appending is amortized constant time.
+template<typename T>
+  void
+  Seq<T>::grow(std::size_t n) {
+    std::size_t cap = capacity() * 2;
+    if (cap < n)
+      cap = n;
+    std::size_t bytes = cap * sizeof(T*);
+    T** p = static_cast<T**>(arena ? arena->allocate(bytes) : ::operator new(bytes));
+    std::size_t k = size();
+    std::copy(first, last, p);
+    free();
+    first = p;
+    last = p + k;
+    limit = p + cap;
+  }
+
+// Release the storage of the elements, if it was allocated on the heap.
+template<typename T>
+  void
+  Seq<T>::free() {
+    if (first != local and not arena)
+      ::operator delete(first);
+  }
+
+template<typename T>
+  void
+  Seq<T>::push_back(T* p) {
+    if (last == limit)
+      grow(size() + 1);
+    *last++ = p;
+  }
+
+template<typename T>
+  void
+  Seq<T>::resize(std::size_t n, T* p) {
+    reserve(n);
+    if (n > size())
+      std::fill(last, first + n, p);
+    last = first + n;
+  }
+
+// Insert p before pos.
+template<typename T>
+  auto
+  Seq<T>::insert(const_iterator pos, T* p) -> iterator {
+    T* v[] {p};
+    return insert(pos, v, v + 1);
+  }
+
+// Insert the elements in [a, b) before pos.
+template<typename T>
+  template<typename I>
+    auto
+    Seq<T>::insert(const_iterator pos, I a, I b) -> iterator {
+      std::size_t i = pos - first;
+      std::size_t n = std::distance(a, b);
+      reserve(size() + n);
+      iterator p = first + i;
+      std::copy_backward(p, last, last + n);
+      std::copy(a, b, p);
+      last += n;
+      return p;
+    }
+
+// Remove the elements in [a, b).
+template<typename T>
+  auto
+  Seq<T>::erase(const_iterator a, const_iterator b) -> iterator {
+    iterator p = first + (a - first);
+    last = std::copy(first + (b - first), last, p);
+    return p;
+  }
+
+template<typename T>
+  void
+  Seq<T>::assign(std::size_t n, T* p) {
+    clear();
+    resize(n, p);
+  }
+
+template<typename T>
+  template<typename I>
+    void
+    Seq<T>::assign(I a, I b) {
+      clear();
+      insert(end(), a, b);
+    }
+
+
+// -------------------------------------------------------------------------- //
+// Conversion and testing
+
+
+// Returns the node t converted to the node type U. If the kind of t
+// is not a kind of U, the resulting term is null.
 template<typename U, typename T>
   inline U*
-  as(T* t) { return dynamic_cast<U*>(t); }
+  as(T* t) {
+    return t and U::has_kind(t->kind) ? static_cast<U*>(t) : nullptr;
+  }
 
 template<typename U, typename T>
   inline const U*
-  as(const T* t) { return dynamic_cast<const U*>(t); }
+  as(const T* t) {
+    return t and U::has_kind(t->kind) ? static_cast<const U*>(t) : nullptr;
+  }
 
 // Returns true if node t has dynamic type U.
 template<typename U, typename T>
@@ -1,20 +1,25 @@
 
 #include <cctype>
 #include <algorithm>
+#include <mutex>
 #include <unordered_set>
 
 #include "string.hpp"
 
 namespace {
 
-// The string table.
+// The string table. Strings may be interned by several threads.
 static std::unordered_set<std::string> strings_;
+static std::mutex strings_mutex_;
 
 } // namesapce
 
 // Returns a pointer to a unique string with the same spelling as str.
 const std::string* 
-String::intern(const std::string& str) { return &*strings_.insert(str).first; }
+String::intern(const std::string& str) {
+  std::lock_guard<std::mutex> lock(strings_mutex_);
+  return &*strings_.insert(str).first;
+}
 
 // Convert a string to lowercase.
 String
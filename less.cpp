@@ -1,15 +1,21 @@
 
 #include "ast.hpp"
+#include "table.hpp"
 
 #include "lang/debug.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 // -------------------------------------------------------------------------- //
 // Less-than-comparison for expressions
 //
 // The less-than comparison for expresssions weakly orders them by
-// their kind and their subterms.
+// their kind and their subterms. On values, the order is total and
+// consistent with the same-term relation: two values are the same
+// when neither is less than the other. Strings are ordered by their
+// text, and tuples, records, and lists are ordered lexicographically
+// by their elements.
 
 namespace {
 
@@ -46,6 +52,32 @@ template<typename T>
     return is_less(a->t3, b->t3);
   }
 
+// Compare the elements of two sequences lexicographically.
+template<typename T>
+  inline bool
+  less_seq(Seq<T>* a, Seq<T>* b) {
+    return std::lexicographical_compare(a->begin(), a->end(),
+                                        b->begin(), b->end(),
+                                        Expr_less());
+  }
+
+// Strings are ordered by their text.
+inline bool
+less_str(Str* a, Str* b) { return a->value().str() < b->value().str(); }
+
+// Tables are ordered lexicographically by their rows.
+inline bool
+less_table(Table* a, Table* b) {
+  std::size_t n = std::min(a->rows(), b->rows());
+  for (std::size_t i = 0; i < n; ++i) {
+    if (is_less_row(a, i, b, i))
+      return true;
+    if (is_less_row(b, i, a, i))
+      return false;
+  }
+  return a->rows() < b->rows();
+}
+
 } // namespace
 
 bool
@@ -60,20 +92,30 @@ is_less(Expr* a, Expr* b) {
   case true_term: return false;
   case false_term: return false;
   case int_term: return as<Int>(a)->value() < as<Int>(b)->value();
+  case str_term: return less_str(as<Str>(a), as<Str>(b));
   case if_term: return less_ternary(as<If>(a), as<If>(b));
   case succ_term: return less_unary(as<Succ>(a), as<Succ>(b));
   case pred_term: return less_unary(as<Pred>(a), as<Pred>(b));
   case iszero_term: return less_unary(as<Iszero>(a), as<Iszero>(b));
   case var_term: return less_binary(as<Var>(a), as<Var>(b));
   case abs_term: return less_binary(as<Abs>(a), as<Abs>(b));
-  case app_term: return less_binary(as<App>(a), as<App>(a));
+  case app_term: return less_binary(as<App>(a), as<App>(b));
   case ref_term: return less_unary(as<Ref>(a), as<Ref>(b));
   case def_term: return less_unary(as<Def>(a), as<Def>(b));
+  case init_term: return less_binary(as<Init>(a), as<Init>(b));
+  case tuple_term: return less_seq(as<Tuple>(a)->elems(), as<Tuple>(b)->elems());
+  case list_term: return less_seq(as<List>(a)->elems(), as<List>(b)->elems());
+  case record_term: return less_seq(as<Record>(a)->members(), as<Record>(b)->members());
+  case table_term: return less_table(as<Table>(a), as<Table>(b));
   case kind_type: return false;
   case unit_type: return false;
   case bool_type: return false;
   case nat_type: return false;
+  case str_type: return false;
   case arrow_type: return less_binary(as<Arrow_type>(a), as<Arrow_type>(b));
+  case tuple_type: return less_seq(as<Tuple_type>(a)->types(), as<Tuple_type>(b)->types());
+  case list_type: return less_unary(as<List_type>(a), as<List_type>(b));
+  case record_type: return less_seq(as<Record_type>(a)->members(), as<Record_type>(b)->members());
   default: break;
   }
   lang_unreachable(format("comparison of unknown node '{}'", node_name(a)));
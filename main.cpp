@@ -7,14 +7,60 @@
 #include "syntax.hpp"
 #include "elab.hpp"
 #include "ast.hpp"
+#include "fold.hpp"
 #include "eval.hpp"
 
 //remove after testing
 #include "type.hpp"
 
-int main() {
+int main(int argc, char* argv[]) {
   Language lang;
 
+  // The trees of the program are allocated in this arena. The nodes
+  // created by the language itself are kept on the heap.
+  Arena program;
+  Arena_guard guard(&program);
+
+  // ------------------------------------------------------------------------ //
+  // Options
+  //
+  // The evaluation mode is selected by '--eval=subst' (the default),
+  // '--eval=env', '--eval=vm', '--eval=step', or '--eval=lazy'. When
+  // evaluating by steps, '--fuel=n' limits the evaluation to n steps.
+  // The option '--memo=n' caches the values of up to n function calls.
+  // Constant folding is disabled by '--no-fold'. The option
+  // '--threads=n' evaluates independent statements on n threads.
+  Eval_mode mode = subst_eval;
+  std::size_t fuel = -1;
+  std::size_t memo = 0;
+  bool folding = true;
+  std::size_t threads = 1;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--eval=subst")
+      mode = subst_eval;
+    else if (arg == "--eval=env")
+      mode = env_eval;
+    else if (arg == "--eval=vm")
+      mode = vm_eval;
+    else if (arg == "--eval=lazy")
+      mode = lazy_eval;
+    else if (arg == "--eval=step")
+      mode = step_eval;
+    else if (arg.compare(0, 7, "--fuel=") == 0)
+      fuel = std::stoul(arg.substr(7));
+    else if (arg.compare(0, 7, "--memo=") == 0)
+      memo = std::stoul(arg.substr(7));
+    else if (arg == "--no-fold")
+      folding = false;
+    else if (arg.compare(0, 10, "--threads=") == 0)
+      threads = std::stoul(arg.substr(10));
+    else {
+      std::cerr << "unknown option '" << arg << "'\n";
+      return -1;
+    }
+  }
+
   // ------------------------------------------------------------------------ //
   // Character input
   using Iter = std::istreambuf_iterator<char>;
@@ -58,16 +104,30 @@ int main() {
   }
   std::cout << "== elaborated ==\n" << pretty(prog) << '\n';
 
+  // ------------------------------------------------------------------------ //
+  // Folding
+  //
+  // Replace the constant subterms of the program by their values,
+  // and inline small functions applied to constants.
+  if (folding)
+    if (Term* term = as<Term>(prog))
+      prog = fold(term);
+
   // ------------------------------------------------------------------------ //
   // Evaluation
   //
   // Evaluate the syntax tree, producing a partially evalutaed
   // abstract syntax tree.
   if (Term* term = as<Term>(prog)) {
-    Evaluator eval;
+    Evaluator eval(mode, fuel);
+    eval.memo = memo;
+    eval.threads = threads;
     std::cout << "== output ==\n";
     Expr* result = eval(term);
-    std::cout << "== result ==\n" << pretty(result) << '\n';
+    if (eval.suspended)
+      std::cout << "== suspended ==\n" << pretty(result) << '\n';
+    else
+      std::cout << "== result ==\n" << pretty(result) << '\n';
   } else {
     std::cout << "== no evaluation ==\n";
   }
@@ -0,0 +1,76 @@
+#include "memo.hpp"
+
+// -------------------------------------------------------------------------- //
+// Memo keys
+
+std::size_t
+Memo_hash::operator()(const Memo_key& k) const {
+  std::size_t h = std::hash<Term*>()(k.fn);
+  for (Term* a : k.args)
+    h = hash_combine(h, hash(a));
+  return h;
+}
+
+bool
+Memo_eq::operator()(const Memo_key& a, const Memo_key& b) const {
+  if (a.fn != b.fn or a.args.size() != b.args.size())
+    return false;
+  for (std::size_t i = 0; i < a.args.size(); ++i)
+    if (not is_same(a.args[i], b.args[i]))
+      return false;
+  return true;
+}
+
+// Returns true when the value t can be an argument of a memoized call.
+// These are the values that can be hashed. Calls taking functions
+// are not memoized.
+bool
+is_memo_arg(Term* t) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case table_term:
+    return true;
+  case record_term:
+    for (Term* m : *as<Record>(t)->members()) {
+      Term* v = as<Term>(as<Init>(m)->value());
+      if (not v or not is_memo_arg(v))
+        return false;
+    }
+    return true;
+  default:
+    return false;
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Memo tables
+
+// Returns the value of the call k, or nullptr if it is not in the
+// table. The entry found becomes the most recently used.
+Term*
+Memo_table::find(const Memo_key& k) {
+  auto iter = index.find(k);
+  if (iter == index.end())
+    return nullptr;
+  entries.splice(entries.begin(), entries, iter->second);
+  return iter->second->second;
+}
+
+// Add the value v of the call k to the table, removing the least
+// recently used entry if the table is full.
+void
+Memo_table::insert(const Memo_key& k, Term* v) {
+  if (capacity == 0 or index.count(k) != 0)
+    return;
+  if (entries.size() == capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+  entries.emplace_front(k, v);
+  index.emplace(k, entries.begin());
+}
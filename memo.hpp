@@ -0,0 +1,55 @@
+
+#ifndef MEMO_HPP
+#define MEMO_HPP
+
+#include "ast.hpp"
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// This module defines a cache of the results of function calls. Every
+// term except 'print' is pure, so a call of the same function on the
+// same argument values always has the same value. Arguments are hashed
+// and compared as values (see hash and is_same), and functions are
+// compared by identity.
+
+// -------------------------------------------------------------------------- //
+// Memo tables
+
+// A call of a function (an abstraction or a multi-parameter function)
+// on the values of its arguments.
+struct Memo_key {
+  Term* fn;
+  std::vector<Term*> args;
+};
+
+struct Memo_hash {
+  std::size_t operator()(const Memo_key&) const;
+};
+
+struct Memo_eq {
+  bool operator()(const Memo_key&, const Memo_key&) const;
+};
+
+// A table of the values of calls, holding at most 'capacity' entries.
+// When the table is full, the least recently used entry is removed to
+// make room for a new one.
+struct Memo_table {
+  Memo_table(std::size_t n)
+    : capacity(n) { }
+
+  Term* find(const Memo_key&);
+  void insert(const Memo_key&, Term*);
+
+  using Entry = std::pair<Memo_key, Term*>;
+  using Entry_list = std::list<Entry>;
+
+  std::size_t capacity;
+  Entry_list entries; // Most recently used first
+  std::unordered_map<Memo_key, Entry_list::iterator, Memo_hash, Memo_eq> index;
+};
+
+bool is_memo_arg(Term*);
+
+#endif
@@ -0,0 +1,337 @@
+#include "par.hpp"
+#include "eval.hpp"
+#include "value.hpp"
+
+#include "lang/debug.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+// -------------------------------------------------------------------------- //
+// Dependencies
+
+namespace {
+
+template<typename T>
+  inline bool
+  get_defs_unary(T* t, std::vector<Def*>& ds) {
+    return get_defs(t->t1, ds);
+  }
+
+template<typename T>
+  inline bool
+  get_defs_binary(T* t, std::vector<Def*>& ds) {
+    return get_defs(t->t1, ds) and get_defs(t->t2, ds);
+  }
+
+template<typename T>
+  inline bool
+  get_defs_ternary(T* t, std::vector<Def*>& ds) {
+    return get_defs(t->t1, ds) and get_defs(t->t2, ds) and get_defs(t->t3, ds);
+  }
+
+template<typename T>
+  inline bool
+  get_defs_seq(Seq<T>* ts, std::vector<Def*>& ds) {
+    for (T* t : *ts) {
+      Term* t0 = as<Term>(t);
+      if (t0 and not get_defs(t0, ds))
+        return false;
+    }
+    return true;
+  }
+
+// Adds the definition referred to by t, if any.
+bool
+get_defs_ref(Ref* t, std::vector<Def*>& ds) {
+  if (Def* d = as<Def>(t->decl()))
+    if (std::find(ds.begin(), ds.end(), d) == ds.end())
+      ds.push_back(d);
+  return true;
+}
+
+// Adds the definitions referred to by the expression e, when it is
+// a term.
+bool
+get_defs_expr(Expr* e, std::vector<Def*>& ds) {
+  if (Term* t = as<Term>(e))
+    return get_defs(t, ds);
+  return true;
+}
+
+} // namespace
+
+// Adds to ds the definitions referred to by the term t. Returns false
+// when t has a term whose references are not known, in which case t
+// must be assumed to refer to every definition.
+bool
+get_defs(Term* t, std::vector<Def*>& ds) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case var_term:
+  case table_term:
+    return true;
+  case ref_term: return get_defs_ref(as<Ref>(t), ds);
+  case if_term: return get_defs_ternary(as<If>(t), ds);
+  case succ_term: return get_defs_unary(as<Succ>(t), ds);
+  case pred_term: return get_defs_unary(as<Pred>(t), ds);
+  case iszero_term: return get_defs_unary(as<Iszero>(t), ds);
+  case not_term: return get_defs_unary(as<Not>(t), ds);
+  case and_term: return get_defs_binary(as<And>(t), ds);
+  case or_term: return get_defs_binary(as<Or>(t), ds);
+  case equals_term: return get_defs_binary(as<Equals>(t), ds);
+  case less_term: return get_defs_binary(as<Less>(t), ds);
+  case abs_term: return get_defs(as<Abs>(t)->term(), ds);
+  case fn_term: return get_defs(as<Fn>(t)->term(), ds);
+  case app_term: return get_defs_binary(as<App>(t), ds);
+  case call_term:
+    return get_defs(as<Call>(t)->fn(), ds) and get_defs_seq(as<Call>(t)->args(), ds);
+  case tuple_term: return get_defs_seq(as<Tuple>(t)->elems(), ds);
+  case list_term: return get_defs_seq(as<List>(t)->elems(), ds);
+  case record_term: return get_defs_seq(as<Record>(t)->members(), ds);
+  case comma_term: return get_defs_seq(as<Comma>(t)->elems(), ds);
+  case init_term: return get_defs_expr(as<Init>(t)->value(), ds);
+  case proj_term: return get_defs_binary(as<Proj>(t), ds);
+  case mem_term: return get_defs_binary(as<Mem>(t), ds);
+  case def_term: return get_defs_expr(as<Def>(t)->value(), ds);
+  case print_term: return get_defs_expr(as<Print>(t)->expr(), ds);
+  case select_term: return get_defs_ternary(as<Select_from_where>(t), ds);
+  case join_on_term: return get_defs_ternary(as<Join>(t), ds);
+  case union_term: return get_defs_binary(as<Union>(t), ds);
+  case intersect_term: return get_defs_binary(as<Intersect>(t), ds);
+  case except_term: return get_defs_binary(as<Except>(t), ds);
+  case group_term: return get_defs_binary(as<Group>(t), ds);
+  case aggregate_term: return get_defs(as<Aggregate>(t)->column(), ds);
+  default: return false;
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Thread pools
+
+Pool::Pool(std::size_t n)
+  : queues(n), outer(current_arena()), arenas(outer ? n : 0) {
+  threads.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    threads.emplace_back(&Pool::run, this, i);
+}
+
+// Stop the threads of the pool. Tasks that have not started are not
+// run.
+Pool::~Pool() {
+  {
+    std::lock_guard<std::mutex> lock(m);
+    stop = true;
+  }
+  cv.notify_all();
+  for (std::thread& t : threads)
+    t.join();
+  for (Arena& a : arenas)
+    outer->adopt(a);
+}
+
+// Submit the task t, whose dependencies have been added. The task is
+// run once they are done. Tasks are given to the threads in turn.
+void
+Pool::submit(Task* t) {
+  if (--t->waiting == 0)
+    push(turn++ % queues.size(), t);
+}
+
+// Make the task b wait for the task a. If a has failed, so does b.
+void
+Pool::depend(Task* a, Task* b) {
+  std::lock_guard<std::mutex> lock(a->m);
+  if (not a->done) {
+    ++b->waiting;
+    a->next.push_back(b);
+  } else if (a->error) {
+    std::lock_guard<std::mutex> lock_b(b->m);
+    if (not b->error)
+      b->error = a->error;
+  }
+}
+
+// Run tasks on the ith thread until the pool is stopped.
+void
+Pool::run(std::size_t i) {
+  Arena_guard guard(outer ? &arenas[i] : nullptr);
+  for (;;) {
+    if (Task* t = pop(i)) {
+      execute(i, t);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [this] { return stop or queued > 0; });
+    if (stop)
+      return;
+  }
+}
+
+// Returns the next task for the ith thread: the newest task in its own
+// queue, or the oldest task in the queue of another thread. Returns
+// nullptr when there are no tasks.
+Task*
+Pool::pop(std::size_t i) {
+  for (std::size_t k = 0; k < queues.size(); ++k) {
+    Queue& q = queues[(i + k) % queues.size()];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.tasks.empty())
+      continue;
+    Task* t;
+    if (k == 0) {
+      t = q.tasks.back();
+      q.tasks.pop_back();
+    } else {
+      t = q.tasks.front();
+      q.tasks.pop_front();
+    }
+    --queued;
+    return t;
+  }
+  return nullptr;
+}
+
+// Add the ready task t to the queue of the ith thread, and wake a
+// thread to run it.
+void
+Pool::push(std::size_t i, Task* t) {
+  {
+    std::lock_guard<std::mutex> lock(queues[i].m);
+    queues[i].tasks.push_back(t);
+  }
+  ++queued;
+  {
+    std::lock_guard<std::mutex> lock(m);
+  }
+  cv.notify_one();
+}
+
+// Evaluate the statement of the task t on the ith thread. The output
+// of every print statement evaluated by the task, including those
+// nested in definitions, is kept with the task. The tasks waiting
+// only for t are added to the queue of the thread.
+//
+// A task whose dependency failed is not evaluated; it fails with the
+// same error.
+void
+Pool::execute(std::size_t i, Task* t) {
+  if (not t->error) {
+    std::ostringstream os;
+    std::ostream* prev = set_output(&os);
+    try {
+      t->value = eval(t->stmt);
+    } catch (...) {
+      t->error = std::current_exception();
+    }
+    set_output(prev);
+    t->output = os.str();
+  }
+
+  std::vector<Task*> next;
+  {
+    std::lock_guard<std::mutex> lock(t->m);
+    t->done = true;
+    next.swap(t->next);
+  }
+  t->cv.notify_all();
+
+  for (Task* n : next) {
+    if (t->error) {
+      std::lock_guard<std::mutex> lock(n->m);
+      if (not n->error)
+        n->error = t->error;
+    }
+    if (--n->waiting == 0)
+      push(i, n);
+  }
+}
+
+
+// -------------------------------------------------------------------------- //
+// Parallel evaluation
+
+namespace {
+
+// Wait for the task t, then write its output. If the task failed, its
+// error is thrown.
+void
+finish(Task* t) {
+  std::unique_lock<std::mutex> lock(t->m);
+  t->cv.wait(lock, [t] { return t->done; });
+  if (t->error)
+    std::rethrow_exception(t->error);
+  std::cout << t->output;
+}
+
+} // namespace
+
+// Compute the multi-step evaluation of the program t on n threads.
+// Each statement is evaluated by a task that waits for the definitions
+// it refers to. A statement whose references are not known waits for
+// every preceding definition.
+//
+// An index statement modifies the table it indexes, so it is evaluated
+// alone, once every preceding statement is done. Later statements are
+// not started before it.
+//
+// The output of each statement is written once it and every preceding
+// statement are done, so the output is the same as for eval. The value
+// of the program is the value of its last statement.
+Term*
+eval_parallel(Term* t, std::size_t n) {
+  Prog* p = as<Prog>(t);
+  if (not p)
+    return eval(t);
+  Term_seq* ss = p->stmts();
+  if (ss->empty())
+    return get_unit();
+
+  std::vector<Task*> tasks;
+  std::unordered_map<Def*, Task*> defs;
+  std::size_t written = 0;
+  Term* result;
+  {
+    Pool pool(n);
+    for (Term* s : *ss) {
+      Task* task = new Task(s);
+      tasks.push_back(task);
+      if (is<Index>(s)) {
+        for (; written + 1 < tasks.size(); ++written)
+          finish(tasks[written]);
+        task->value = eval(s);
+        task->done = true;
+        continue;
+      }
+
+      std::vector<Def*> ds;
+      if (get_defs(s, ds)) {
+        for (Def* d : ds) {
+          auto iter = defs.find(d);
+          if (iter != defs.end())
+            pool.depend(iter->second, task);
+        }
+      } else {
+        for (auto& x : defs)
+          pool.depend(x.second, task);
+      }
+      if (Def* d = as<Def>(s))
+        defs[d] = task;
+      pool.submit(task);
+    }
+    for (; written < tasks.size(); ++written)
+      finish(tasks[written]);
+    result = tasks.back()->value;
+  }
+
+  for (Task* task : tasks)
+    delete task;
+  return result;
+}
@@ -0,0 +1,92 @@
+
+#ifndef PAR_HPP
+#define PAR_HPP
+
+#include "ast.hpp"
+
+#include "lang/arena.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// This module evaluates the statements of a program concurrently. Each
+// statement is a task that runs once the definitions it refers to have
+// been evaluated, so definitions that do not depend on each other are
+// evaluated at the same time. The output of print statements is kept
+// with their tasks and written in program order.
+
+// -------------------------------------------------------------------------- //
+// Tasks
+
+// The evaluation of a statement of a program. A task is ready to run
+// when the tasks of the definitions it refers to are done. When it is
+// done, its dependents are notified, and its output (if any) and value
+// are kept until they are read.
+struct Task {
+  Task(Term* t)
+    : stmt(t) { }
+
+  Term* stmt;
+  std::vector<Task*> next;   // Tasks waiting for this one
+  std::atomic<int> waiting {1}; // Unfinished dependencies, plus one
+                                // until the task is submitted
+  std::string output;
+  Term* value = nullptr;
+  std::exception_ptr error;
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool done = false;
+};
+
+// -------------------------------------------------------------------------- //
+// Thread pools
+
+// A work-stealing pool of threads. Each thread has its own queue of
+// ready tasks. A thread runs the most recently added task in its own
+// queue, or, when its queue is empty, takes the oldest task from the
+// queue of another thread. The tasks made ready by a task are added to
+// the queue of the thread that ran it.
+//
+// When the pool is created in an arena, each thread allocates nodes
+// in an arena of its own. These are added to the outer arena when the
+// pool is destroyed.
+struct Pool {
+  Pool(std::size_t);
+  ~Pool();
+
+  void submit(Task*);
+  void depend(Task*, Task*);
+
+  void run(std::size_t);
+  Task* pop(std::size_t);
+  void push(std::size_t, Task*);
+  void execute(std::size_t, Task*);
+
+  struct Queue {
+    std::mutex m;
+    std::deque<Task*> tasks;
+  };
+
+  std::vector<Queue> queues;
+  std::vector<std::thread> threads;
+  Arena* outer;
+  std::vector<Arena> arenas;
+  std::atomic<std::size_t> queued {0};
+  std::atomic<std::size_t> turn {0};
+  std::mutex m;
+  std::condition_variable cv;
+  bool stop = false;
+};
+
+bool get_defs(Term*, std::vector<Def*>&);
+
+Term* eval_parallel(Term*, std::size_t);
+
+#endif
@@ -379,6 +379,22 @@ parse_select_expr(Parser& p) {
     return nullptr;
 }
 
+// Parse a grouping.
+//
+//    stmt ::= group cols from table
+Tree*
+parse_group_expr(Parser& p) {
+  if (const Token* k = parse::accept(p, group_tok)) {
+    if (Tree* t1 = parse_expr(p)) {
+      if (parse::expect(p, from_tok)) {
+        if (Tree* t2 = parse_expr(p))
+          return new Group_tree(k, t1, t2);
+      }
+    }
+  }
+  return nullptr;
+}
+
 // Parse a primary expression.
 //
 //    primary-term ::= primary-lambda-term | grouped-term
@@ -668,6 +684,42 @@ parse_typeof_expr(Parser& p) {
   return nullptr;
 }
 
+// Parse an index statement.
+//
+//    index-expr ::= 'index' prefix-expr
+Tree*
+parse_index_expr(Parser& p) {
+  if (const Token* k = parse::accept(p, index_tok)) {
+    if (Tree* t = parse_prefix_expr(p))
+      return new Index_tree(k, t);
+    else
+      parse::parse_error(p) << "expected 'prefix-expr' after 'index'";
+  }
+  return nullptr;
+}
+
+// Parse an aggregate expression.
+//
+//    aggregate-expr ::= aggregate-op prefix-expr
+//    aggregate-op ::= 'count' | 'sum' | 'min' | 'max'
+Tree*
+parse_aggregate_expr(Parser& p) {
+  const Token* k = parse::accept(p, count_tok);
+  if (not k)
+    k = parse::accept(p, sum_tok);
+  if (not k)
+    k = parse::accept(p, min_tok);
+  if (not k)
+    k = parse::accept(p, max_tok);
+  if (k) {
+    if (Tree* t = parse_prefix_expr(p))
+      return new Aggregate_tree(k, t);
+    else
+      parse::parse_error(p) << "expected 'prefix-expr' after aggregate";
+  }
+  return nullptr;
+}
+
 // Parse a not expression
 //
 //    not-expr ::= 'not' expr
@@ -704,7 +756,8 @@ parse_schema_expr(Parser& p) {
 // Parse a prefix expr.
 //
 //    prefix-expr ::= if-expr | succ-epxr | pred-expr | iszero-expr
-//                    | not-expr | print-expr | typeof-expr
+//                    | not-expr | print-expr | typeof-expr | index-expr
+//                    | group-expr | aggregate-expr
 Tree*
 parse_prefix_expr(Parser& p) {
   if (Tree* t = parse_if_expr(p))
@@ -723,6 +776,12 @@ parse_prefix_expr(Parser& p) {
     return t;
   if (Tree* t = parse_not_expr(p))
     return t;
+  if (Tree* t = parse_index_expr(p))
+    return t;
+  if (Tree* t = parse_group_expr(p))
+    return t;
+  if (Tree* t = parse_aggregate_expr(p))
+    return t;
   return parse_postfix_expr(p);
 }
 
@@ -0,0 +1,622 @@
+#include "plan.hpp"
+#include "table.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include "lang/debug.hpp"
+
+#include <set>
+
+// -------------------------------------------------------------------------- //
+// Schemas
+
+// Returns the type of the result of the plan p: a list of records
+// whose members are the columns of p.
+Type*
+get_type(Plan* p) {
+  Term_seq* vars = new Term_seq();
+  vars->reserve(p->schema.size());
+  for (const Plan_column& c : p->schema)
+    vars->push_back(c.var);
+  Type* rec_type = get_record_type(vars);
+  return get_list_type(rec_type);
+}
+
+// Returns the index of the column named n in the schema s. A column
+// of the table defined by d is preferred; otherwise, the first column
+// with that name is chosen. Returns -1 if there is no such column.
+std::size_t
+find_column(const Plan_schema& s, Def* d, Name* n) {
+  for (std::size_t i = 0; i < s.size(); ++i)
+    if (s[i].def == d and is_same(s[i].var->name(), n))
+      return i;
+  for (std::size_t i = 0; i < s.size(); ++i)
+    if (is_same(s[i].var->name(), n))
+      return i;
+  return -1;
+}
+
+namespace {
+
+// Returns the definition naming the table t, or nullptr if t is not
+// a named table.
+Def*
+get_table_def(Term* t) {
+  if (Ref* ref = as<Ref>(t))
+    return as<Def>(ref->decl());
+  return as<Def>(t);
+}
+
+// Returns the columns of the table t, which is named by d.
+Plan_schema
+get_schema(Def* d, Term* t) {
+  Plan_schema s;
+  List_type* type = as<List_type>(get_type(t));
+  for (Term* v : *as<Record_type>(type->type())->members())
+    s.push_back({d, as<Var>(v)});
+  return s;
+}
+
+// Returns the columns of s1 followed by those of s2.
+Plan_schema
+concat(const Plan_schema& s1, const Plan_schema& s2) {
+  Plan_schema s = s1;
+  s.insert(s.end(), s2.begin(), s2.end());
+  return s;
+}
+
+// Returns the columns of s, not qualified by any definition. This is
+// the schema of a set operation, whose rows may come from either of
+// its inputs.
+Plan_schema
+unqualify(const Plan_schema& s) {
+  Plan_schema r = s;
+  for (Plan_column& c : r)
+    c.def = nullptr;
+  return r;
+}
+
+// If t has the form 'd.x', returns the definition d. Otherwise,
+// returns nullptr.
+Def*
+get_column_def(Term* t) {
+  if (Mem* m = as<Mem>(t))
+    return get_table_def(m->record());
+  return nullptr;
+}
+
+// If t has the form 'd.x', returns the member variable x. Otherwise,
+// returns nullptr.
+Var*
+get_column_var(Term* t) {
+  if (Mem* m = as<Mem>(t))
+    if (Ref* ref = as<Ref>(m->member()))
+      return as<Var>(ref->decl());
+  return nullptr;
+}
+
+// Returns the columns of the input schema s named by the projection
+// list p of a select.
+Plan_schema
+get_projection(Term* p, const Plan_schema& s) {
+  Expr_seq* cols = new Expr_seq {p};
+  if (Comma* c = as<Comma>(p))
+    cols = c->elems();
+
+  Plan_schema r;
+  for (Expr* e : *cols) {
+    Term* t = as<Term>(e);
+    Var* v = get_column_var(t);
+    std::size_t n = find_column(s, get_column_def(t), v->name());
+    lang_assert(n != std::size_t(-1), format("no column '{}'", pretty(t)));
+    r.push_back(s[n]);
+  }
+  return r;
+}
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Plan construction
+
+// Returns true when t is a query: a select, a join, or a set operation
+// on tables.
+bool
+is_query(Term* t) {
+  switch (t->kind) {
+  case select_term:
+  case join_on_term:
+  case group_term:
+    return true;
+  case union_term:
+  case intersect_term:
+  case except_term:
+    return is_table_type(get_type(t));
+  default:
+    return false;
+  }
+}
+
+namespace {
+
+// Returns a plan for the grouping t.
+Plan*
+make_group_plan(Group* t) {
+  Plan* p = make_plan(t->table());
+  Expr_seq* elems = new Expr_seq {t->group_list()};
+  if (Comma* c = as<Comma>(t->group_list()))
+    elems = c->elems();
+
+  Plan_schema s;
+  std::vector<Plan_group_item> items;
+  for (Expr* e : *elems) {
+    Aggregate* a = as<Aggregate>(e);
+    Term* col = a ? a->column() : as<Term>(e);
+    Var* v = get_column_var(col);
+    std::size_t n = find_column(p->schema, get_column_def(col), v->name());
+    lang_assert(n != std::size_t(-1), format("no column '{}'", pretty(col)));
+    if (a) {
+      items.push_back({false, a->op, p->schema[n]});
+      s.push_back({nullptr, a->var()});
+    } else {
+      items.push_back({true, count_agg, p->schema[n]});
+      s.push_back({nullptr, v});
+    }
+  }
+  return new Group_plan(s, p, items);
+}
+
+// Returns a plan for a set operation of the given kind on t1 and t2.
+Plan*
+make_set_plan(Plan_kind k, Term* t1, Term* t2) {
+  Plan* l = make_plan(t1);
+  Plan* r = make_plan(t2);
+  return new Set_plan(k, unqualify(l->schema), l, r);
+}
+
+} // namespace
+
+// Returns the plan computing the value of the query t, exactly as it
+// is written. When t is not a query, the plan scans its value.
+//
+//    select t1 from t2 where t3 => project(t1, filter(t3, plan(t2)))
+//    t1 join t2 on t3           => join(t3, plan(t1), plan(t2))
+//    t1 union t2                => union(plan(t1), plan(t2))
+//    group t1 from t2           => group(t1, plan(t2))
+Plan*
+make_plan(Term* t) {
+  if (not is_query(t))
+    return new Scan_plan(get_schema(get_table_def(t), t), t);
+
+  switch (t->kind) {
+  case select_term: {
+    Select_from_where* s = as<Select_from_where>(t);
+    Plan* p = new Filter_plan(make_plan(s->table()), s->cond());
+    return new Project_plan(get_projection(s->projection_list(), p->schema), p);
+  }
+  case join_on_term: {
+    Join* j = as<Join>(t);
+    Plan* l = make_plan(j->table_a());
+    Plan* r = make_plan(j->table_b());
+    return new Join_plan(concat(l->schema, r->schema), l, r, j->join_cond());
+  }
+  case union_term:
+    return make_set_plan(union_plan, as<Union>(t)->t1, as<Union>(t)->t2);
+  case intersect_term:
+    return make_set_plan(intersect_plan, as<Intersect>(t)->t1, as<Intersect>(t)->t2);
+  case except_term:
+    return make_set_plan(except_plan, as<Except>(t)->t1, as<Except>(t)->t2);
+  case group_term:
+    return make_group_plan(as<Group>(t));
+  default:
+    break;
+  }
+  lang_unreachable(format("planning unknown query '{}'", node_name(t)));
+}
+
+
+// -------------------------------------------------------------------------- //
+// Predicate pushdown
+//
+// Conditions are split into their conjuncts, and each conjunct is
+// moved as close as possible to the tables whose columns it reads.
+// Adjacent selections are merged, and the conditions of a selection
+// above a join that read both inputs become part of the join's
+// condition, where they may be used as join keys.
+
+namespace {
+
+using Def_set = std::set<Def*>;
+using Term_list = std::vector<Term*>;
+
+// Add the conjuncts of the condition c to cs.
+void
+get_conjuncts(Term* c, Term_list& cs) {
+  if (And* a = as<And>(c)) {
+    get_conjuncts(a->t1, cs);
+    get_conjuncts(a->t2, cs);
+  } else {
+    cs.push_back(c);
+  }
+}
+
+// Returns the conjunction of the conditions in cs, or nullptr if cs
+// is empty.
+Term*
+make_conjunction(const Term_list& cs) {
+  Term* c = nullptr;
+  for (Term* t : cs)
+    c = c ? new And(get_bool_type(), c, t) : t;
+  return c;
+}
+
+// Add the definitions referred to by t to ds. Returns false if t has
+// a form whose references are not known.
+bool
+get_defs(Term* t, Def_set& ds) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+    return true;
+  case ref_term:
+    if (Def* d = as<Def>(as<Ref>(t)->decl()))
+      ds.insert(d);
+    return true;
+  case mem_term:
+    return get_defs(as<Mem>(t)->record(), ds);
+  case and_term:
+    return get_defs(as<And>(t)->t1, ds) and get_defs(as<And>(t)->t2, ds);
+  case or_term:
+    return get_defs(as<Or>(t)->t1, ds) and get_defs(as<Or>(t)->t2, ds);
+  case equals_term:
+    return get_defs(as<Equals>(t)->t1, ds) and get_defs(as<Equals>(t)->t2, ds);
+  case less_term:
+    return get_defs(as<Less>(t)->t1, ds) and get_defs(as<Less>(t)->t2, ds);
+  case not_term:
+    return get_defs(as<Not>(t)->t1, ds);
+  case succ_term:
+    return get_defs(as<Succ>(t)->t1, ds);
+  case pred_term:
+    return get_defs(as<Pred>(t)->t1, ds);
+  case iszero_term:
+    return get_defs(as<Iszero>(t)->t1, ds);
+  default:
+    return false;
+  }
+}
+
+// Returns the definitions qualifying the columns of s.
+Def_set
+get_defs(const Plan_schema& s) {
+  Def_set ds;
+  for (const Plan_column& c : s)
+    if (c.def)
+      ds.insert(c.def);
+  return ds;
+}
+
+// The input of a join that a condition can be evaluated on.
+enum Side {
+  left_side,
+  right_side,
+  both_sides,
+  no_side,
+};
+
+// Determine which input of a join with the given columns the
+// condition c reads. Definitions that do not name either input are
+// constants for the join.
+Side
+get_side(Term* c, const Def_set& left, const Def_set& right) {
+  Def_set ds;
+  if (not get_defs(c, ds))
+    return no_side;
+  bool l = false;
+  bool r = false;
+  for (Def* d : ds) {
+    bool in_l = left.count(d);
+    bool in_r = right.count(d);
+    if (in_l and in_r)
+      return no_side;
+    l = l or in_l;
+    r = r or in_r;
+  }
+  if (l and r)
+    return both_sides;
+  if (r)
+    return right_side;
+  return left_side;
+}
+
+Plan* push_filters(Plan*);
+
+// Delete the selection f, which is replaced by its input. Returns
+// that input.
+Plan*
+release_input(Filter_plan* f) {
+  Plan* p = f->input;
+  f->input = nullptr;
+  delete f;
+  return p;
+}
+
+// Place the conditions cs on the rows of p, as close to its tables as
+// possible. Returns the resulting plan.
+Plan*
+push_conditions(Plan* p, Term_list cs) {
+  if (cs.empty())
+    return p;
+
+  switch (p->kind) {
+  case filter_plan: {
+    // Merge adjacent selections.
+    Filter_plan* f = static_cast<Filter_plan*>(p);
+    get_conjuncts(f->cond, cs);
+    return push_conditions(release_input(f), cs);
+  }
+  case project_plan: {
+    // Select before projecting.
+    Project_plan* j = static_cast<Project_plan*>(p);
+    j->input = push_conditions(j->input, cs);
+    return j;
+  }
+  case join_plan: {
+    Join_plan* j = static_cast<Join_plan*>(p);
+    Def_set left = get_defs(j->left->schema);
+    Def_set right = get_defs(j->right->schema);
+    Term_list lcs;
+    Term_list rcs;
+    Term_list jcs;
+    Term_list rest;
+    for (Term* c : cs) {
+      switch (get_side(c, left, right)) {
+      case left_side: lcs.push_back(c); break;
+      case right_side: rcs.push_back(c); break;
+      case both_sides: jcs.push_back(c); break;
+      case no_side: rest.push_back(c); break;
+      }
+    }
+    j->left = push_conditions(j->left, lcs);
+    j->right = push_conditions(j->right, rcs);
+    if (not jcs.empty()) {
+      get_conjuncts(j->cond, jcs);
+      j->cond = make_conjunction(jcs);
+    }
+    if (rest.empty())
+      return j;
+    return new Filter_plan(j, make_conjunction(rest));
+  }
+  default:
+    return new Filter_plan(p, make_conjunction(cs));
+  }
+}
+
+// Push the conditions of selections and joins in p toward its tables.
+Plan*
+push_filters(Plan* p) {
+  switch (p->kind) {
+  case filter_plan: {
+    Filter_plan* f = static_cast<Filter_plan*>(p);
+    Term_list cs;
+    get_conjuncts(f->cond, cs);
+    return push_conditions(push_filters(release_input(f)), cs);
+  }
+  case project_plan: {
+    Project_plan* j = static_cast<Project_plan*>(p);
+    j->input = push_filters(j->input);
+    return j;
+  }
+  case join_plan: {
+    // Conditions of the join that read only one input select the
+    // rows of that input.
+    Join_plan* j = static_cast<Join_plan*>(p);
+    j->left = push_filters(j->left);
+    j->right = push_filters(j->right);
+    Def_set left = get_defs(j->left->schema);
+    Def_set right = get_defs(j->right->schema);
+    Term_list cs;
+    get_conjuncts(j->cond, cs);
+    Term_list lcs;
+    Term_list rcs;
+    Term_list jcs;
+    for (Term* c : cs) {
+      switch (get_side(c, left, right)) {
+      case left_side: lcs.push_back(c); break;
+      case right_side: rcs.push_back(c); break;
+      default: jcs.push_back(c); break;
+      }
+    }
+    j->left = push_conditions(j->left, lcs);
+    j->right = push_conditions(j->right, rcs);
+    j->cond = jcs.empty() ? get_true() : make_conjunction(jcs);
+    return j;
+  }
+  case union_plan:
+  case intersect_plan:
+  case except_plan: {
+    Set_plan* s = static_cast<Set_plan*>(p);
+    s->left = push_filters(s->left);
+    s->right = push_filters(s->right);
+    return s;
+  }
+  case group_plan: {
+    Group_plan* g = static_cast<Group_plan*>(p);
+    g->input = push_filters(g->input);
+    return g;
+  }
+  default:
+    return p;
+  }
+}
+
+} // namespace
+
+// Returns true when the term t may refer to the tables whose columns
+// are in the schema s. Terms whose form is not known are assumed to
+// refer to them.
+bool
+mentions(Term* t, const Plan_schema& s) {
+  Def_set ds;
+  if (not get_defs(t, ds))
+    return true;
+  for (const Plan_column& c : s)
+    if (ds.count(c.def))
+      return true;
+  return false;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Column pruning
+//
+// Each table is projected onto the columns that are read by the
+// operators above it, so that selections and joins copy only the
+// columns that are needed.
+
+namespace {
+
+// The columns needed from the result of a plan.
+struct Column_need {
+  bool has(const Plan_column&) const;
+  void add(Term*);
+
+  bool all = false;
+  Def_set defs;
+  std::set<std::pair<Def*, String>> cols;
+};
+
+// Returns the name of the column c.
+inline String
+get_name(const Plan_column& c) { return as<Id>(c.var->name())->t1; }
+
+// Returns true when the column c is needed.
+bool
+Column_need::has(const Plan_column& c) const {
+  return all or defs.count(c.def) or cols.count({c.def, get_name(c)});
+}
+
+// Add the columns read by the condition t. Columns of the form 'd.x'
+// are added individually. A definition referred to otherwise needs
+// all of its columns, and a term of unknown form needs every column.
+void
+Column_need::add(Term* t) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+    return;
+  case ref_term:
+    if (Def* d = as<Def>(as<Ref>(t)->decl()))
+      defs.insert(d);
+    return;
+  case mem_term: {
+    Def* d = get_column_def(t);
+    Var* v = get_column_var(t);
+    if (d and v)
+      cols.insert({d, as<Id>(v->name())->t1});
+    else
+      add(as<Mem>(t)->record());
+    return;
+  }
+  case and_term: add(as<And>(t)->t1); add(as<And>(t)->t2); return;
+  case or_term: add(as<Or>(t)->t1); add(as<Or>(t)->t2); return;
+  case equals_term: add(as<Equals>(t)->t1); add(as<Equals>(t)->t2); return;
+  case less_term: add(as<Less>(t)->t1); add(as<Less>(t)->t2); return;
+  case not_term: add(as<Not>(t)->t1); return;
+  case succ_term: add(as<Succ>(t)->t1); return;
+  case pred_term: add(as<Pred>(t)->t1); return;
+  case iszero_term: add(as<Iszero>(t)->t1); return;
+  default:
+    all = true;
+    return;
+  }
+}
+
+// Remove the columns of p that are not needed. The schemas of the
+// operators whose results have the columns of their inputs are
+// updated to match those inputs.
+Plan*
+prune(Plan* p, const Column_need& need) {
+  switch (p->kind) {
+  case scan_plan: {
+    if (need.all)
+      return p;
+    Plan_schema s;
+    for (const Plan_column& c : p->schema)
+      if (need.has(c))
+        s.push_back(c);
+    if (s.size() == p->schema.size())
+      return p;
+
+    // A table needs at least one column to have rows.
+    if (s.empty())
+      s.push_back(p->schema.front());
+    return new Project_plan(s, p);
+  }
+  case filter_plan: {
+    Filter_plan* f = static_cast<Filter_plan*>(p);
+    Column_need n = need;
+    n.add(f->cond);
+    f->input = prune(f->input, n);
+    f->schema = f->input->schema;
+    return f;
+  }
+  case project_plan: {
+    Project_plan* j = static_cast<Project_plan*>(p);
+    Column_need n;
+    for (const Plan_column& c : j->schema)
+      n.cols.insert({c.def, get_name(c)});
+    j->input = prune(j->input, n);
+    return j;
+  }
+  case join_plan: {
+    Join_plan* j = static_cast<Join_plan*>(p);
+    Column_need n = need;
+    n.add(j->cond);
+    j->left = prune(j->left, n);
+    j->right = prune(j->right, n);
+    j->schema = concat(j->left->schema, j->right->schema);
+    return j;
+  }
+  case union_plan:
+  case intersect_plan:
+  case except_plan: {
+    // Rows are compared on all of their columns.
+    Set_plan* s = static_cast<Set_plan*>(p);
+    Column_need n;
+    n.all = true;
+    s->left = prune(s->left, n);
+    s->right = prune(s->right, n);
+    return s;
+  }
+  case group_plan: {
+    Group_plan* g = static_cast<Group_plan*>(p);
+    Column_need n;
+    for (const Plan_group_item& i : g->items)
+      n.cols.insert({i.column.def, get_name(i.column)});
+    g->input = prune(g->input, n);
+    return g;
+  }
+  }
+  lang_unreachable("unknown plan");
+}
+
+} // namespace
+
+// Rewrite the plan p to reduce the work of evaluating it. Conditions
+// are pushed toward the tables they read, adjacent selections are
+// merged, and the columns that are not needed are removed as soon as
+// the tables are read.
+Plan*
+optimize(Plan* p) {
+  p = push_filters(p);
+  Column_need all;
+  all.all = true;
+  return prune(p, all);
+}
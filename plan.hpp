@@ -0,0 +1,141 @@
+
+#ifndef PLAN_HPP
+#define PLAN_HPP
+
+#include "ast.hpp"
+
+#include <vector>
+
+// This module defines logical query plans. A query (a select, join,
+// or set operation on tables) is translated into a tree of relational
+// operators, which is rewritten to reduce the work of evaluating it
+// before it is evaluated.
+
+// -------------------------------------------------------------------------- //
+// Plans
+
+// A column of the result of a plan. The column is identified by the
+// member variable of the table it was read from and the definition
+// of that table. Queries refer to columns by these names (e.g., 'x.a').
+// The definition is null when the table is not named.
+struct Plan_column {
+  Def* def;
+  Var* var;
+};
+
+using Plan_schema = std::vector<Plan_column>;
+
+// The kinds of plans.
+enum Plan_kind {
+  scan_plan,      // The value of a table term
+  filter_plan,    // The rows of a plan satisfying a condition
+  project_plan,   // Some columns of a plan
+  join_plan,      // Pairs of rows of two plans satisfying a condition
+  union_plan,     // The rows of either plan
+  intersect_plan, // The rows of both plans
+  except_plan,    // The rows of the first plan not in the second
+  group_plan,     // The keys and aggregates of groups of rows of a plan
+};
+
+// The base class of all plans. The schema of a plan describes the
+// columns of its result, in order. A plan owns its inputs.
+struct Plan {
+  Plan(Plan_kind k, const Plan_schema& s)
+    : kind(k), schema(s) { }
+  virtual ~Plan() { }
+
+  Plan_kind kind;
+  Plan_schema schema;
+};
+
+// Evaluates a term whose value is a table. The definition naming the
+// table, if any, qualifies the columns of the result.
+struct Scan_plan : Plan {
+  Scan_plan(const Plan_schema& s, Term* t)
+    : Plan(scan_plan, s), table(t) { }
+
+  Term* table;
+};
+
+// Selects the rows of the input satisfying the condition.
+struct Filter_plan : Plan {
+  Filter_plan(Plan* p, Term* c)
+    : Plan(filter_plan, p->schema), input(p), cond(c) { }
+
+  ~Filter_plan() { delete input; }
+
+  Plan* input;
+  Term* cond;
+};
+
+// Selects the columns of the input named by the schema.
+struct Project_plan : Plan {
+  Project_plan(const Plan_schema& s, Plan* p)
+    : Plan(project_plan, s), input(p) { }
+
+  ~Project_plan() { delete input; }
+
+  Plan* input;
+};
+
+// Pairs the rows of the left and right inputs satisfying the
+// condition. The columns of the left input come first.
+struct Join_plan : Plan {
+  Join_plan(const Plan_schema& s, Plan* l, Plan* r, Term* c)
+    : Plan(join_plan, s), left(l), right(r), cond(c) { }
+
+  ~Join_plan() {
+    delete left;
+    delete right;
+  }
+
+  Plan* left;
+  Plan* right;
+  Term* cond;
+};
+
+// A union, intersection, or difference of the rows of two inputs
+// with the same columns.
+struct Set_plan : Plan {
+  Set_plan(Plan_kind k, const Plan_schema& s, Plan* l, Plan* r)
+    : Plan(k, s), left(l), right(r) { }
+
+  ~Set_plan() {
+    delete left;
+    delete right;
+  }
+
+  Plan* left;
+  Plan* right;
+};
+
+// A column of the result of a grouping: either a key column of the
+// input or an aggregate of a column of the input.
+struct Plan_group_item {
+  bool key;
+  Aggregate_op op;
+  Plan_column column;
+};
+
+// Groups the rows of the input having the same values of the key
+// columns. The result has a row for each group, whose columns are
+// the items of the grouping.
+struct Group_plan : Plan {
+  Group_plan(const Plan_schema& s, Plan* p, const std::vector<Plan_group_item>& is)
+    : Plan(group_plan, s), input(p), items(is) { }
+
+  ~Group_plan() { delete input; }
+
+  Plan* input;
+  std::vector<Plan_group_item> items;
+};
+
+bool is_query(Term*);
+Plan* make_plan(Term*);
+Plan* optimize(Plan*);
+
+Type* get_type(Plan*);
+std::size_t find_column(const Plan_schema&, Def*, Name*);
+bool mentions(Term*, const Plan_schema&);
+
+#endif
@@ -1,5 +1,6 @@
 
 #include "ast.hpp"
+#include "table.hpp"
 
 #include "lang/debug.hpp"
 
@@ -111,6 +112,30 @@ same_record(Record* a, Record* b) {
   return true;
 }
 
+// Two sequences are the same if they have the same elements in the
+// same order.
+inline bool
+same_seq(Term_seq* a, Term_seq* b) {
+  if (a->size() != b->size())
+    return false;
+  for (std::size_t i = 0; i < a->size(); ++i)
+    if (not is_same((*a)[i], (*b)[i]))
+      return false;
+  return true;
+}
+
+// Two tables are the same if they have the same rows in the
+// same order.
+inline bool
+same_table(Table* a, Table* b) {
+  if (a->rows() != b->rows() or a->columns()->size() != b->columns()->size())
+    return false;
+  for (std::size_t i = 0; i < a->rows(); ++i)
+    if (not is_same_row(a, i, b, i))
+      return false;
+  return true;
+}
+
 } // namespace
 
 
@@ -124,6 +149,7 @@ is_same(Expr* a, Expr* b) {
   case true_term: return true;
   case false_term: return true;
   case int_term: return as<Int>(a)->value() == as<Int>(b)->value();
+  case str_term: return as<Str>(a)->value() == as<Str>(b)->value();
   case if_term: return same_ternary(as<If>(a), as<If>(b));
   case succ_term: return same_unary(as<Succ>(a), as<Succ>(b));
   case pred_term: return same_unary(as<Pred>(a), as<Pred>(b));
@@ -134,10 +160,14 @@ is_same(Expr* a, Expr* b) {
   case ref_term: return same_ref(as<Ref>(a), as<Ref>(b));
   case init_term: return same_init(as<Init>(a), as<Init>(b));
   case record_term: return same_record(as<Record>(a), as<Record>(b));
+  case tuple_term: return same_seq(as<Tuple>(a)->elems(), as<Tuple>(b)->elems());
+  case list_term: return same_seq(as<List>(a)->elems(), as<List>(b)->elems());
+  case table_term: return same_table(as<Table>(a), as<Table>(b));
   case kind_type: return true;
   case unit_type: return true;
   case bool_type: return true;
   case nat_type: return true;
+  case str_type: return true;
   case arrow_type: return same_binary(as<Arrow_type>(a), as<Arrow_type>(b));
   case record_type: return same_record_type(as<Record_type>(a), as<Record_type>(b));
   case list_type: return is_same(as<List_type>(a)->type(), as<List_type>(b)->type());
@@ -4,6 +4,7 @@
 #include "lang/error.hpp"
 #include "lang/debug.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 namespace {
@@ -73,12 +74,33 @@ declare(Expr* t) {
 // or nullptr if no such name exists.
 Expr*
 lookup(Name* n) {
-  Scope* s = current_scope();
-  while (s) {
+  int depth, slot;
+  return lookup(n, depth, slot);
+}
+
+// Return the declaration associated with the name n, or nullptr if
+// no such name exists. When the declaration is a parameter, depth is
+// set to the number of lambda scopes between the current scope and
+// the one declaring the parameter, and slot to the position of the
+// parameter. Otherwise, both are set to -1.
+Expr*
+lookup(Name* n, int& depth, int& slot) {
+  depth = slot = -1;
+  int d = 0;
+  for (Scope* s = current_scope(); s; s = s->parent) {
     auto iter = s->find(n);
-    if (iter != s->end())
+    if (iter != s->end()) {
+      if (s->kind == lambda_scope) {
+        auto p = std::find(s->parms.begin(), s->parms.end(), iter->second);
+        if (p != s->parms.end()) {
+          depth = d;
+          slot = p - s->parms.begin();
+        }
+      }
       return iter->second;
-    s = s->parent;
+    }
+    if (s->kind == lambda_scope)
+      ++d;
   }
   return nullptr;
 }
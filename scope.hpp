@@ -5,6 +5,7 @@
 #include "ast.hpp"
 
 #include <map>
+#include <vector>
 
 // Determines the kind of scope.
 enum Scope_kind {
@@ -17,6 +18,10 @@ enum Scope_kind {
 // the lookup of bound identifiers. Each scope is linked to its 
 // parent or enclosing scope, allowing lookup to work "outwards" 
 // as a declaration corresponding to that name is searched for.
+//
+// The parameters of the function declaring a lambda scope are kept in
+// order. Other variables declared in the scope (e.g., the fields of a
+// record type) are not parameters.
 struct Scope : std::map<Name*, Expr*, Expr_less> {
   Scope(Scope_kind k)
     : kind(k), parent(nullptr), counter(0) { }
@@ -26,6 +31,7 @@ struct Scope : std::map<Name*, Expr*, Expr_less> {
   Scope_kind kind;
   Scope* parent;
   int counter;
+  std::vector<Var*> parms;
 };
 
 void push_scope(Scope_kind);
@@ -39,6 +45,7 @@ bool in_member_scope();
 Expr* declare(Name*, Expr*);
 Expr* declare(Expr*);
 Expr* lookup(Name*);
+Expr* lookup(Name*, int&, int&);
 
 Name* fresh_name();
 
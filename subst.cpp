@@ -79,6 +79,64 @@ template<typename T>
 inline Expr*
 subst_var(Var* v, const Subst& sub) { return v; }
 
+// Returns the substitution sub without the mappings of the variables
+// in vs. A function whose parameter is mapped by sub rebinds it, so
+// references in its body are not replaced. This happens when a copy of
+// a function is substituted into the body of the function itself.
+template<typename T>
+  inline Subst
+  unbind(const Subst& sub, T* const* first, T* const* last) {
+    Subst s = sub;
+    for (; first != last; ++first)
+      s.erase(*first);
+    return s;
+  }
+
+// Substitute into the abstracted term of an abstraction. The variable
+// is not substituted, and shadows any mapping of itself.
+//
+//    [x->s]\x.t = \x.t
+//    [x->s]\y.t = \y.[x->s]t
+inline Expr*
+subst_abs(Abs* t, const Subst& sub) {
+  if (sub.count(t->t1)) {
+    Subst s = unbind(sub, &t->t1, &t->t1 + 1);
+    return new Abs(t->loc, get_type(t), t->t1, subst_term(t->t2, s));
+  }
+  return new Abs(t->loc, get_type(t), t->t1, subst_term(t->t2, sub));
+}
+
+// Substitute into the abstracted term of a function. As with
+// abstractions, the parameters are not substituted, and shadow any
+// mappings of themselves.
+//
+//    [x->s]\(v1, ..., vn).t = \(v1, ..., vn).[x->s]t
+inline Expr*
+subst_fn(Fn* t, const Subst& sub) {
+  Term_seq* ps = t->parms();
+  for (Term* p : *ps) {
+    if (sub.count(p)) {
+      Subst s = unbind(sub, ps->begin(), ps->end());
+      return new Fn(t->loc, get_type(t), t->t1, subst_term(t->t2, s));
+    }
+  }
+  Term* t2 = subst_term(t->t2, sub);
+  return new Fn(t->loc, get_type(t), t->t1, t2);
+}
+
+// Substitute into a function call.
+//
+//    [x->s]t(t1, ..., tn) = [x->s]t([x->s]t1, ..., [x->s]tn)
+inline Expr*
+subst_call(Call* t, const Subst& sub) {
+  Term* t1 = subst_term(t->t1, sub);
+  Term_seq* ts = new Term_seq();
+  ts->reserve(t->t2->size());
+  for (Term* a : *t->t2)
+    ts->push_back(subst_term(a, sub));
+  return new Call(t->loc, get_type(t), t1, ts);
+}
+
 // Substitute for the reference.
 //
 //    [x->s]x = s
@@ -102,6 +160,52 @@ subst_mem(Mem* t, const Subst& sub) {
   return new Mem(t->loc, get_unit_type(), t1, t2);
 }
 
+// Substitute into each term of a sequence.
+//
+//    [x->s](t1, ..., tn) = ([x->s]t1, ..., [x->s]tn)
+template<typename T>
+  inline Seq<T>*
+  subst_seq(Seq<T>* ts, const Subst& sub) {
+    Seq<T>* r = new Seq<T>();
+    r->reserve(ts->size());
+    for (T* t : *ts)
+      r->push_back(as<T>(subst(t, sub)));
+    return r;
+  }
+
+// Substitute into the elements of a tuple, list, or record.
+//
+//    [x->s]{t1, ..., tn} = {[x->s]t1, ..., [x->s]tn}
+//    [x->s][t1, ..., tn] = [[x->s]t1, ..., [x->s]tn]
+template<typename T>
+  inline Expr*
+  subst_elems(T* t, const Subst& sub) {
+    return new T(t->loc, get_type(t), subst_seq(t->t1, sub));
+  }
+
+// Substitute into the value of an initializer.
+//
+//    [x->s]n = t = n = [x->s]t
+inline Expr*
+subst_init(Init* t, const Subst& sub) {
+  return new Init(t->loc, get_type(t), t->name(), subst(t->value(), sub));
+}
+
+// Substitute into the sequence of a comma term.
+inline Expr*
+subst_comma(Comma* t, const Subst& sub) {
+  return new Comma(t->loc, get_type(t), subst_seq(t->elems(), sub));
+}
+
+// Substitute into the column of an aggregate.
+//
+//    [x->s]f t = f [x->s]t
+inline Expr*
+subst_aggregate(Aggregate* t, const Subst& sub) {
+  Term* t1 = subst_term(t->t1, sub);
+  return new Aggregate(t->loc, get_type(t), t->op, t1, t->var());
+}
+
 } // namespace
 
 Expr*
@@ -113,6 +217,7 @@ subst(Expr* e, const Subst& sub) {
   case false_term: return e;
   case if_term: return subst_ternary_term(as<If>(e), sub);
   case int_term: return e;
+  case str_term: return e;
   case and_term: return subst_binary_term(as<And>(e), sub);
   case or_term: return subst_binary_term(as<Or>(e), sub);
   case equals_term: return subst_binary_term(as<Equals>(e), sub);
@@ -122,10 +227,27 @@ subst(Expr* e, const Subst& sub) {
   case pred_term: return subst_unary_term(as<Pred>(e), sub);
   case iszero_term: return subst_unary_term(as<Iszero>(e), sub);
   case var_term: return subst_var(as<Var>(e), sub);
-  case abs_term: return subst_binary_term(as<Abs>(e), sub);
+  case abs_term: return subst_abs(as<Abs>(e), sub);
+  case fn_term: return subst_fn(as<Fn>(e), sub);
   case app_term: return subst_binary_term(as<App>(e), sub);
+  case call_term: return subst_call(as<Call>(e), sub);
   case ref_term: return subst_ref(as<Ref>(e), sub);
   case mem_term: return subst_mem(as<Mem>(e), sub);
+  case tuple_term: return subst_elems(as<Tuple>(e), sub);
+  case list_term: return subst_elems(as<List>(e), sub);
+  case record_term: return subst_elems(as<Record>(e), sub);
+  case init_term: return subst_init(as<Init>(e), sub);
+  case comma_term: return subst_comma(as<Comma>(e), sub);
+  case proj_term: return subst_binary_term(as<Proj>(e), sub);
+  case table_term: return e;
+  case select_term: return subst_ternary_term(as<Select_from_where>(e), sub);
+  case join_on_term: return subst_ternary_term(as<Join>(e), sub);
+  case union_term: return subst_binary_term(as<Union>(e), sub);
+  case intersect_term: return subst_binary_term(as<Intersect>(e), sub);
+  case except_term: return subst_binary_term(as<Except>(e), sub);
+  case index_term: return subst_unary_term(as<Index>(e), sub);
+  case group_term: return subst_binary_term(as<Group>(e), sub);
+  case aggregate_term: return subst_aggregate(as<Aggregate>(e), sub);
   case kind_type: return e;
   case unit_type: return e;
   case bool_type: return e;
@@ -15,8 +15,10 @@
 // time (e.g., [x->s1, y->s2]t).
 //
 // Note that while the key type of the map is an expr, it refers
-// to terms that declare names or values.
-struct Subst : std::map<Expr*, Expr*, Expr_less> {
+// to terms that declare names or values. Keys are compared by
+// identity, so a reference is replaced only when it refers to the
+// mapped declaration, not to another variable with the same name.
+struct Subst : std::map<Expr*, Expr*> {
   Subst() = default;
   Subst(Expr*, Expr*);
   
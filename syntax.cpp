@@ -32,6 +32,9 @@ init_trees() {
   init_node(union_tree, "union-tree");
   init_node(intersect_tree, "intersect-tree");
   init_node(except_tree, "except-tree");
+  init_node(index_tree, "index-tree");
+  init_node(group_tree, "group-tree");
+  init_node(aggregate_tree, "aggregate-tree");
   init_node(and_tree, "and-tree");
   init_node(or_tree, "or-tree");
   init_node(not_tree, "not-tree");
@@ -175,6 +178,21 @@ pp_except(std::ostream& os, Except_tree* t) {
   os << pretty(t->t1) << " except " << pretty(t->t2);
 }
 
+void
+pp_index(std::ostream& os, Index_tree* t) {
+  os << "index " << pretty(t->column());
+}
+
+void
+pp_group(std::ostream& os, Group_tree* t) {
+  os << "group " << pretty(t->t1) << " from " << pretty(t->t2);
+}
+
+void
+pp_aggregate(std::ostream& os, Aggregate_tree* t) {
+  os << t->op() << ' ' << pretty(t->expr());
+}
+
 void
 pp_and(std::ostream& os, And_tree* t) {
   os << pretty(t->t1) << " and " << pretty(t->t2);
@@ -243,6 +261,9 @@ print(std::ostream& os, Tree* t) {
   case union_tree: return pp_union(os, as<Union_tree>(t));
   case intersect_tree: return pp_intersect(os, as<Intersect_tree>(t));
   case except_tree: return pp_except(os, as<Except_tree>(t));
+  case index_tree: return pp_index(os, as<Index_tree>(t));
+  case group_tree: return pp_group(os, as<Group_tree>(t));
+  case aggregate_tree: return pp_aggregate(os, as<Aggregate_tree>(t));
   case and_tree: return pp_and(os, as<And_tree>(t));
   case or_tree: return pp_or(os, as<Or_tree>(t));
   case not_tree: return pp_not(os, as<Not_tree>(t));
@@ -31,6 +31,9 @@ constexpr Node_kind join_on_tree = make_tree_node(162); // t1 join t2 on t3
 constexpr Node_kind union_tree   = make_tree_node(163); // t1 union t2
 constexpr Node_kind intersect_tree = make_tree_node(164); // t1 intersect t2
 constexpr Node_kind except_tree  = make_tree_node(165); // t1 except t2
+constexpr Node_kind index_tree   = make_tree_node(166); // index t
+constexpr Node_kind group_tree   = make_tree_node(167); // group t1 from t2
+constexpr Node_kind aggregate_tree = make_tree_node(168); // count t, sum t, ...
 constexpr Node_kind print_tree   = make_tree_node(200); // print t
 constexpr Node_kind typeof_tree  = make_tree_node(201); // typeof t
 constexpr Node_kind and_tree     = make_tree_node(300); // t1 and t2
@@ -40,7 +43,11 @@ constexpr Node_kind eq_comp_tree = make_tree_node(303); // t1 == t2
 constexpr Node_kind less_tree    = make_tree_node(304); // t1 < t2
 constexpr Node_kind prog_tree    = make_tree_node(500); // stmts
 
-struct Tree : Node { using Node::Node; };
+struct Tree : Node {
+  using Node::Node;
+
+  static constexpr bool has_kind(Node_kind k) { return is_tree_node(k); }
+};
 
 using Tree_seq = Seq<Tree>;
 
@@ -48,6 +55,8 @@ struct Id_tree : Tree {
   Id_tree(const Token* k)
     : Tree(id_tree, k->loc), t1(k) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == id_tree; }
+
   const Token* value() const { return t1; }
   
   const Token* t1;
@@ -57,6 +66,8 @@ struct Lit_tree : Tree {
   Lit_tree(const Token* k)
     : Tree(lit_tree, k->loc), t1(k) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == lit_tree; }
+
   const Token* value() const { return t1; }
   
   const Token* t1;
@@ -67,6 +78,8 @@ struct Init_tree : Tree {
   Init_tree(Tree* n, Tree* t)
     : Tree(init_tree, n->loc), t1(n), t2(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == init_tree; }
+
   Tree* name() const { return t1; }
   Tree* term() const { return t2; }
 
@@ -78,6 +91,8 @@ struct Var_tree : Tree {
   Var_tree(Tree* t1, Tree* t2)
     : Tree(var_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == var_tree; }
+
   Tree* id() const { return t1; }
   Tree* type() const { return t2; }
 
@@ -89,6 +104,8 @@ struct Abs_tree : Tree {
   Abs_tree(const Token* k, Tree* t1, Tree* t2)
     : Tree(abs_tree, k->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == abs_tree; }
+
   Tree* var() const { return t1; }
   Tree* term() const { return t2; }
   
@@ -100,6 +117,8 @@ struct Fn_tree : Tree {
   Fn_tree(const Token* k, Tree_seq* t1, Tree* t2)
     : Tree(fn_tree, k->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == fn_tree; }
+
   Tree_seq* parms() const { return t1; }
   Tree* term() const { return t2; }
   Tree_seq* t1;
@@ -110,6 +129,8 @@ struct Func_tree : Tree {
   Func_tree(Tree* n, Tree_seq* t2, Tree* t3)
     : Tree(func_tree, n->loc), t1(n), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == func_tree; }
+
   Tree* name() const{ return t1; }   
   Tree_seq* parms() const { return t2; }
   Tree* type() const { return t3; }
@@ -124,6 +145,8 @@ struct App_tree : Tree {
   App_tree(Tree* t1, Tree* t2)
     : Tree(app_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == app_tree; }
+
   Tree* fn() const { return t1; }
   Tree* arg() const { return t2; }
 
@@ -135,6 +158,8 @@ struct If_tree : Tree {
   If_tree(const Token* k, Tree* t1, Tree* t2, Tree* t3)
     : Tree(if_tree, k->loc), t1(t1), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == if_tree; }
+
   Tree* cond() const { return t1; }
   Tree* if_true() const { return t2; }
   Tree* if_false() const  { return t3; }
@@ -148,6 +173,8 @@ struct Succ_tree : Tree {
   Succ_tree(const Token* k, Tree* t)
     : Tree(succ_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == succ_tree; }
+
   Tree* arg() const { return t1; }
 
   Tree* t1;
@@ -157,6 +184,8 @@ struct Pred_tree : Tree {
   Pred_tree(const Token* k, Tree* t)
     : Tree(pred_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == pred_tree; }
+
   Tree* arg() const { return t1; }
 
   Tree* t1;
@@ -166,6 +195,8 @@ struct Iszero_tree : Tree {
   Iszero_tree(const Token* k, Tree* t)
     : Tree(iszero_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == iszero_tree; }
+
   Tree* arg() const { return t1; }
 
   Tree* t1;
@@ -175,6 +206,8 @@ struct Arrow_tree : Tree {
   Arrow_tree(Tree* t1, Tree* t2)
     : Tree(arrow_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == arrow_tree; }
+
   Tree* left() const { return t1; }
   Tree* right() const { return t2; }
 
@@ -186,6 +219,8 @@ struct Def_tree : Tree {
   Def_tree(const Token* k, Tree* n, Tree* e)
     : Tree(def_tree, k->loc), t1(n), t2(e) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == def_tree; }
+
   Tree* name() const { return t1; }
   Tree* value() const { return t2; }
 
@@ -197,6 +232,8 @@ struct Print_tree : Tree {
   Print_tree(const Token* k, Tree* t)
     : Tree(print_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == print_tree; }
+
   Tree* expr() const { return t1; }
 
   Tree* t1;
@@ -206,6 +243,8 @@ struct Typeof_tree : Tree {
   Typeof_tree(const Token* k, Tree* t)
     : Tree(typeof_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == typeof_tree; }
+
   Tree* expr() const { return t1; }
 
   Tree* t1;
@@ -219,6 +258,8 @@ struct Tuple_tree : Tree {
   Tuple_tree(const Token* k, Tree_seq* ts)
     : Tree(tuple_tree, k->loc), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == tuple_tree; }
+
   Tree_seq* elems() const { return t1; }
 
   Tree_seq* t1;
@@ -230,6 +271,8 @@ struct List_tree : Tree {
   List_tree(const Token* k, Tree_seq* ts)
     : Tree(list_tree, k->loc), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == list_tree; }
+
   Tree_seq* elems() const { return t1; }
 
   Tree_seq* t1;
@@ -240,6 +283,8 @@ struct Select_tree : Tree {
   Select_tree(const Token* k, Tree* t1, Tree* t2, Tree* t3) 
     : Tree(select_tree, k->loc), t1(t1), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == select_tree; }
+
   Tree* t1;
   Tree* t2;
   Tree* t3;
@@ -250,6 +295,8 @@ struct Join_on_tree : Tree {
   Join_on_tree(const Token* k, Tree* t1, Tree* t2, Tree* t3)
     : Tree(join_on_tree, k->loc), t1(t1), t2(t2), t3(t3) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == join_on_tree; }
+
   Tree* t1;
   Tree* t2;
   Tree* t3;  
@@ -260,6 +307,8 @@ struct Union_tree : Tree {
   Union_tree(Tree* t1, Tree* t2)
     : Tree(union_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == union_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -269,6 +318,8 @@ struct Intersect_tree : Tree {
   Intersect_tree(Tree* t1, Tree* t2)
     : Tree(intersect_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == intersect_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -278,10 +329,52 @@ struct Except_tree : Tree {
   Except_tree(Tree* t1, Tree* t2)
     : Tree(except_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == except_tree; }
+
   Tree* t1;
   Tree* t2;
 };
 
+// A statement of the form 'index t', where t names a column of a
+// table (e.g., 'x.k').
+struct Index_tree : Tree {
+  Index_tree(const Token* k, Tree* t)
+    : Tree(index_tree, k->loc), t1(t) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == index_tree; }
+
+  Tree* column() const { return t1; }
+
+  Tree* t1;
+};
+
+// A grouping of the form 'group t1 from t2'. Each element of t1 is
+// either a column of t2 or an aggregate of one.
+struct Group_tree : Tree {
+  Group_tree(const Token* k, Tree* t1, Tree* t2)
+    : Tree(group_tree, k->loc), t1(t1), t2(t2) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == group_tree; }
+
+  Tree* t1;
+  Tree* t2;
+};
+
+// An aggregate of the form 'f t' where 'f' is one of 'count', 'sum',
+// 'min', or 'max'.
+struct Aggregate_tree : Tree {
+  Aggregate_tree(const Token* k, Tree* t)
+    : Tree(aggregate_tree, k->loc), t0(k), t1(t) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == aggregate_tree; }
+
+  const Token* op() const { return t0; }
+  Tree* expr() const { return t1; }
+
+  const Token* t0;
+  Tree* t1;
+};
+
 // A variant of the form '<t1, ..., tn>' where each ti is a
 // a variable of the form 'x:T' or a member of the form 'x=t'.
 //
@@ -291,6 +384,8 @@ struct Variant_tree : Tree {
   Variant_tree(const Token* k, Tree_seq* ts)
     : Tree(variant_tree, k->loc), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == variant_tree; }
+
   Tree_seq* elems() const { return t1; }
 
   Tree_seq* t1;
@@ -301,6 +396,8 @@ struct Comma_tree : Tree {
   Comma_tree(const Token* k, Tree_seq* ts)
     : Tree(comma_tree, k->loc), t1(ts) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == comma_tree; }
+
   Tree_seq* elems() const { return t1; }
 
   Tree_seq* t1;
@@ -311,6 +408,8 @@ struct Dot_tree : Tree {
   Dot_tree(Tree* t1, Tree* t2)
     : Tree(dot_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == dot_tree; }
+
   Tree* object() const { return t1; }
   Tree* elem() const { return t2; }
 
@@ -322,6 +421,8 @@ struct Dot_tree : Tree {
 struct Prog_tree : Tree {
   Prog_tree(Tree_seq* ts)
     : Tree(prog_tree, no_location), t1(ts) { }
+
+  static constexpr bool has_kind(Node_kind k) { return k == prog_tree; }
   
   Tree_seq* stmts() const { return t1; }
 
@@ -333,6 +434,8 @@ struct And_tree : Tree {
   And_tree(Tree* t1, Tree* t2)
     : Tree(and_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == and_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -342,6 +445,8 @@ struct Or_tree : Tree {
   Or_tree(Tree* t1, Tree* t2)
     : Tree(or_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == or_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -351,6 +456,8 @@ struct Not_tree : Tree {
   Not_tree(const Token* k, Tree* t)
     : Tree(not_tree, k->loc), t1(t) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == not_tree; }
+
   Tree* t1;
 };
 
@@ -359,6 +466,8 @@ struct Eq_comp_tree : Tree {
   Eq_comp_tree(Tree* t1, Tree* t2)
     : Tree(eq_comp_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == eq_comp_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -368,6 +477,8 @@ struct Less_tree : Tree {
   Less_tree(Tree* t1, Tree* t2)
     : Tree(less_tree, t1->loc), t1(t1), t2(t2) { }
 
+  static constexpr bool has_kind(Node_kind k) { return k == less_tree; }
+
   Tree* t1;
   Tree* t2;
 };
@@ -0,0 +1,442 @@
+#include "table.hpp"
+#include "type.hpp"
+#include "value.hpp"
+
+#include "lang/debug.hpp"
+
+#include <algorithm>
+
+// -------------------------------------------------------------------------- //
+// Columns
+
+// Returns the kind of column that stores values of type t.
+Column_kind
+get_column_kind(Type* t) {
+  if (is_bool_type(t))
+    return bool_column;
+  if (is_nat_type(t))
+    return nat_column;
+  if (is_str_type(t))
+    return str_column;
+  return term_column;
+}
+
+// Returns the number of values in the column.
+std::size_t
+Column::size() const {
+  switch (kind) {
+  case bool_column: return bools.size();
+  case nat_column: return nats.size();
+  case str_column: return strs.size();
+  case term_column: return terms.size();
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Reserve storage for n values.
+void
+Column::reserve(std::size_t n) {
+  switch (kind) {
+  case bool_column: return bools.reserve(n);
+  case nat_column: return nats.reserve(n);
+  case str_column: return strs.reserve(n);
+  case term_column: return terms.reserve(n);
+  }
+}
+
+// Returns the nth value of the column as a term. Boolean values are
+// the shared true and false terms; numbers and strings are allocated.
+Term*
+Column::get(std::size_t n) const {
+  switch (kind) {
+  case bool_column:
+    return bools[n] ? get_true() : get_false();
+  case nat_column:
+    return get_int(nats[n]);
+  case str_column:
+    return new Str(get_str_type(), strs[n]);
+  case term_column:
+    return terms[n];
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Append the value t to the column. If t is a number that does not
+// fit in a word, the column is converted to a term column.
+void
+Column::push_back(Term* t) {
+  switch (kind) {
+  case bool_column:
+    bools.push_back(is_true(t));
+    return;
+  case nat_column: {
+    const mpz_t& z = as<Int>(t)->value().data();
+    if (mpz_fits_slong_p(z)) {
+      nats.push_back(mpz_get_ui(z));
+      return;
+    }
+    for (std::size_t i = 0; i < nats.size(); ++i)
+      terms.push_back(get(i));
+    nats.clear();
+    nats.shrink_to_fit();
+    kind = term_column;
+    terms.push_back(t);
+    return;
+  }
+  case str_column:
+    strs.push_back(as<Str>(t)->value());
+    return;
+  case term_column:
+    terms.push_back(t);
+    return;
+  }
+}
+
+// Append the nth value of the column c to this column.
+void
+Column::push_back(const Column& c, std::size_t n) {
+  if (kind != c.kind) {
+    push_back(c.get(n));
+    return;
+  }
+  switch (kind) {
+  case bool_column: return bools.push_back(c.bools[n]);
+  case nat_column: return nats.push_back(c.nats[n]);
+  case str_column: return strs.push_back(c.strs[n]);
+  case term_column: return terms.push_back(c.terms[n]);
+  }
+}
+
+// Returns the hash code of the nth value in the column c. This is
+// the same as the hash code of the value as a term.
+std::size_t
+hash(const Column& c, std::size_t n) {
+  switch (c.kind) {
+  case bool_column: return hash(c.bools[n] ? get_true() : get_false());
+  case nat_column: return hash_int(c.nats[n]);
+  case str_column: return hash_str(c.strs[n]);
+  case term_column: return hash(c.terms[n]);
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns true when the mth value of a is the same as the nth value
+// of b.
+bool
+is_same(const Column& a, std::size_t m, const Column& b, std::size_t n) {
+  if (a.kind != b.kind)
+    return is_same(a.get(m), b.get(n));
+  switch (a.kind) {
+  case bool_column: return a.bools[m] == b.bools[n];
+  case nat_column: return a.nats[m] == b.nats[n];
+  case str_column: return a.strs[m] == b.strs[n];
+  case term_column: return is_same(a.terms[m], b.terms[n]);
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns true when the mth value of a is less than the nth value of
+// b. This is consistent with is_less on the values as terms.
+bool
+is_less(const Column& a, std::size_t m, const Column& b, std::size_t n) {
+  if (a.kind != b.kind)
+    return is_less(a.get(m), b.get(n));
+  switch (a.kind) {
+  case bool_column: return is_less(a.get(m), b.get(n));
+  case nat_column: return a.nats[m] < b.nats[n];
+  case str_column: return a.strs[m].str() < b.strs[n].str();
+  case term_column: return is_less(a.terms[m], b.terms[n]);
+  }
+  lang_unreachable("unknown column kind");
+}
+
+// Returns true when the values of the column c are in order.
+bool
+is_sorted(const Column& c) {
+  for (std::size_t i = 1; i < c.size(); ++i)
+    if (is_less(c, i, c, i - 1))
+      return false;
+  return true;
+}
+
+// Returns the indexes of the values of c in sorted order. Indexes of
+// equal values remain in their original order.
+std::vector<std::size_t>
+sort_column(const Column& c) {
+  std::vector<std::size_t> perm(c.size());
+  for (std::size_t i = 0; i < perm.size(); ++i)
+    perm[i] = i;
+  if (is_sorted(c))
+    return perm;
+  std::stable_sort(perm.begin(), perm.end(), [&c](std::size_t m, std::size_t n) {
+    return is_less(c, m, c, n);
+  });
+  return perm;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Indexes
+
+// Returns the index on the column c, building it if the column is not
+// already indexed.
+Column_index*
+make_index(Column* c) {
+  if (c->index)
+    return c->index;
+  Column_index* index = new_in_arena<Column_index>();
+  index->rows.reserve(c->size());
+  for (std::size_t n = 0; n < c->size(); ++n)
+    index->rows[hash(*c, n)].push_back(n);
+  index->order = sort_column(*c);
+  c->index = index;
+  return index;
+}
+
+// Returns the rows of the indexed column c whose value is the same as
+// the first value of v, in increasing order.
+std::vector<std::size_t>
+find_equal_rows(const Column& c, const Column& v) {
+  std::vector<std::size_t> rows;
+  auto iter = c.index->rows.find(hash(v, 0));
+  if (iter == c.index->rows.end())
+    return rows;
+  for (std::size_t n : iter->second)
+    if (is_same(c, n, v, 0))
+      rows.push_back(n);
+  return rows;
+}
+
+// Returns the rows of the indexed column c whose value is less than
+// the first value of v, in increasing order.
+std::vector<std::size_t>
+find_less_rows(const Column& c, const Column& v) {
+  const std::vector<std::size_t>& order = c.index->order;
+  auto less = [&](std::size_t n) { return is_less(c, n, v, 0); };
+  auto last = std::partition_point(order.begin(), order.end(), less);
+  std::vector<std::size_t> rows(order.begin(), last);
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+// Returns the rows of the indexed column c whose value is greater
+// than the first value of v, in increasing order.
+std::vector<std::size_t>
+find_greater_rows(const Column& c, const Column& v) {
+  const std::vector<std::size_t>& order = c.index->order;
+  auto not_greater = [&](std::size_t n) { return not is_less(v, 0, c, n); };
+  auto first = std::partition_point(order.begin(), order.end(), not_greater);
+  std::vector<std::size_t> rows(first, order.end());
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Tables
+
+// Returns the number of rows in the table.
+std::size_t
+Table::rows() const {
+  if (t1->empty())
+    return 0;
+  return t1->front()->size();
+}
+
+// Returns true when t is the type of a table, a list of records.
+bool
+is_table_type(Type* t) {
+  if (List_type* l = as<List_type>(t))
+    return is<Record_type>(l->type());
+  return false;
+}
+
+// Returns the record type of the rows of t.
+Record_type*
+get_table_type(Table* t) {
+  return as<Record_type>(as<List_type>(get_type(t))->type());
+}
+
+// Returns the index of the column named n in the table t.
+std::size_t
+find_column(Table* t, Name* n) {
+  Term_seq* vars = get_table_type(t)->members();
+  for (std::size_t i = 0; i < vars->size(); ++i)
+    if (is_same(n, as<Var>((*vars)[i])->name()))
+      return i;
+  lang_unreachable(format("no column named '{}'", pretty(n)));
+}
+
+// Returns a table of type t with empty columns. Storage is reserved
+// for n rows.
+Table*
+make_table(Type* t, std::size_t n) {
+  Record_type* r = as<Record_type>(as<List_type>(t)->type());
+  Column_seq* cols = new_in_arena<Column_seq>();
+  cols->reserve(r->members()->size());
+  for (Term* v : *r->members()) {
+    Column* c = new_in_arena<Column>(get_column_kind(get_type(v)));
+    c->reserve(n);
+    cols->push_back(c);
+  }
+  return new Table(t, cols);
+}
+
+// Returns the nth row of the table t as a record.
+Record*
+get_row(Table* t, std::size_t n) {
+  Record_type* type = get_table_type(t);
+  Term_seq* vars = type->members();
+  Term_seq* ms = new Term_seq();
+  ms->reserve(vars->size());
+  for (std::size_t i = 0; i < vars->size(); ++i) {
+    Var* v = as<Var>((*vars)[i]);
+    Term* value = t->column(i)->get(n);
+    ms->push_back(new Init(get_type(v), v->name(), value));
+  }
+  return new Record(type, ms);
+}
+
+// Append the nth row of the table s to the table t. Both tables
+// must have the same columns.
+void
+append_row(Table* t, Table* s, std::size_t n) {
+  for (std::size_t i = 0; i < t->columns()->size(); ++i)
+    t->column(i)->push_back(*s->column(i), n);
+}
+
+// Returns a table of type type whose columns are the given columns
+// of t. The columns are shared with t.
+Table*
+project_table(Table* t, Type* type, const std::vector<std::size_t>& cols) {
+  Column_seq* cs = new_in_arena<Column_seq>();
+  cs->reserve(cols.size());
+  for (std::size_t n : cols)
+    cs->push_back(t->column(n));
+  return new Table(type, cs);
+}
+
+// Returns a table containing the given rows of t, in order.
+Table*
+select_rows(Table* t, const std::vector<std::size_t>& rows) {
+  Column_seq* cs = new_in_arena<Column_seq>();
+  cs->reserve(t->columns()->size());
+  for (Column* from : *t->columns()) {
+    Column* to = new_in_arena<Column>(from->kind);
+    to->reserve(rows.size());
+    for (std::size_t n : rows)
+      to->push_back(*from, n);
+    cs->push_back(to);
+  }
+  return new Table(get_type(t), cs);
+}
+
+// Returns a table containing the count rows of t starting at the
+// row first.
+Table*
+slice_table(Table* t, std::size_t first, std::size_t count) {
+  Column_seq* cs = new_in_arena<Column_seq>();
+  cs->reserve(t->columns()->size());
+  for (Column* from : *t->columns()) {
+    Column* to = new_in_arena<Column>(from->kind);
+    to->reserve(count);
+    for (std::size_t n = first; n < first + count; ++n)
+      to->push_back(*from, n);
+    cs->push_back(to);
+  }
+  return new Table(get_type(t), cs);
+}
+
+// Returns a table of type type whose columns are those of a followed
+// by those of b. Both tables must have the same number of rows.
+Table*
+merge_tables(Table* a, Table* b, Type* type) {
+  Column_seq* cs = new_in_arena<Column_seq>(*a->columns());
+  cs->insert(cs->end(), b->columns()->begin(), b->columns()->end());
+  return new Table(type, cs);
+}
+
+// Returns the hash code of the nth row of the table t.
+std::size_t
+hash_row(Table* t, std::size_t n) {
+  std::size_t h = 0;
+  for (Column* c : *t->columns())
+    h = hash_combine(h, hash(*c, n));
+  return h;
+}
+
+// Returns true when the mth row of a is lexicographically less than
+// the nth row of b.
+bool
+is_less_row(Table* a, std::size_t m, Table* b, std::size_t n) {
+  for (std::size_t i = 0; i < a->columns()->size(); ++i) {
+    if (is_less(*a->column(i), m, *b->column(i), n))
+      return true;
+    if (is_less(*b->column(i), n, *a->column(i), m))
+      return false;
+  }
+  return false;
+}
+
+// Returns true when the rows of the table t are in order.
+bool
+is_sorted(Table* t) {
+  for (std::size_t i = 1; i < t->rows(); ++i)
+    if (is_less_row(t, i, t, i - 1))
+      return false;
+  return true;
+}
+
+// Returns the indexes of the rows of t in sorted order. Indexes of
+// equal rows remain in their original order.
+std::vector<std::size_t>
+sort_table(Table* t) {
+  std::vector<std::size_t> perm(t->rows());
+  for (std::size_t i = 0; i < perm.size(); ++i)
+    perm[i] = i;
+  if (is_sorted(t))
+    return perm;
+  std::stable_sort(perm.begin(), perm.end(), [t](std::size_t m, std::size_t n) {
+    return is_less_row(t, m, t, n);
+  });
+  return perm;
+}
+
+// Returns true when the mth row of a has the same values as the nth
+// row of b.
+bool
+is_same_row(Table* a, std::size_t m, Table* b, std::size_t n) {
+  for (std::size_t i = 0; i < a->columns()->size(); ++i)
+    if (not is_same(*a->column(i), m, *b->column(i), n))
+      return false;
+  return true;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Row sets
+
+// Insert the nth row of t into the set. Returns true if the set did
+// not already contain a row with the same values.
+bool
+Row_set::insert(Table* t, std::size_t n) {
+  std::vector<Row>& rows = buckets[hash_row(t, n)];
+  for (const Row& r : rows)
+    if (is_same_row(r.first, r.second, t, n))
+      return false;
+  rows.push_back({t, n});
+  return true;
+}
+
+// Returns true if the set contains a row with the same values as the
+// nth row of t.
+bool
+Row_set::contains(Table* t, std::size_t n) const {
+  auto iter = buckets.find(hash_row(t, n));
+  if (iter == buckets.end())
+    return false;
+  for (const Row& r : iter->second)
+    if (is_same_row(r.first, r.second, t, n))
+      return true;
+  return false;
+}
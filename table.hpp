@@ -0,0 +1,123 @@
+
+#ifndef TABLE_HPP
+#define TABLE_HPP
+
+#include "ast.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// This module defines the columnar representation of tables. A table
+// is a list of records whose values are stored by column rather than
+// by row.
+
+// -------------------------------------------------------------------------- //
+// Columns
+
+// The representation of the values in a column. Boolean and natural
+// number values are stored unboxed, strings are stored as interned
+// handles, and all other values are stored as terms.
+enum Column_kind {
+  bool_column,
+  nat_column,
+  str_column,
+  term_column,
+};
+
+struct Column_index;
+
+// A column stores the values of one member of a table's records in
+// a contiguous array. Only the array selected by the column's kind
+// is used.
+//
+// A natural number column holds values that fit in a machine word.
+// When a larger value is added, the column is converted to a term
+// column.
+//
+// Columns, and the sequences of columns of tables, are allocated in
+// the current arena (see new_in_arena).
+struct Column {
+  Column(Column_kind k)
+    : kind(k) { }
+
+  std::size_t size() const;
+  void reserve(std::size_t);
+
+  Term* get(std::size_t) const;
+  void push_back(Term*);
+  void push_back(const Column&, std::size_t);
+
+  Column_kind kind;
+  std::vector<std::uint8_t> bools;
+  std::vector<unsigned long> nats;
+  std::vector<String> strs;
+  std::vector<Term*> terms;
+  Column_index* index = nullptr;
+};
+
+Column_kind get_column_kind(Type*);
+
+std::size_t hash(const Column&, std::size_t);
+bool is_same(const Column&, std::size_t, const Column&, std::size_t);
+bool is_less(const Column&, std::size_t, const Column&, std::size_t);
+bool is_sorted(const Column&);
+std::vector<std::size_t> sort_column(const Column&);
+
+
+// -------------------------------------------------------------------------- //
+// Indexes
+
+// An index on the values of a column. The rows of the column are
+// partitioned by the hash of their value, for finding equal values,
+// and sorted by their value, for finding smaller or larger values.
+// Rows are listed in increasing order within each partition.
+//
+// An index is kept with its column, which is shared by the tables
+// projected from the column's table. Columns are never modified once
+// they belong to a table, so an index does not need to be updated.
+struct Column_index {
+  std::unordered_map<std::size_t, std::vector<std::size_t>> rows;
+  std::vector<std::size_t> order;
+};
+
+Column_index* make_index(Column*);
+
+std::vector<std::size_t> find_equal_rows(const Column&, const Column&);
+std::vector<std::size_t> find_less_rows(const Column&, const Column&);
+std::vector<std::size_t> find_greater_rows(const Column&, const Column&);
+
+
+// -------------------------------------------------------------------------- //
+// Tables
+
+bool is_table_type(Type*);
+Record_type* get_table_type(Table*);
+std::size_t find_column(Table*, Name*);
+
+Table* make_table(Type*, std::size_t);
+Record* get_row(Table*, std::size_t);
+void append_row(Table*, Table*, std::size_t);
+
+Table* project_table(Table*, Type*, const std::vector<std::size_t>&);
+Table* select_rows(Table*, const std::vector<std::size_t>&);
+Table* slice_table(Table*, std::size_t, std::size_t);
+Table* merge_tables(Table*, Table*, Type*);
+
+std::size_t hash_row(Table*, std::size_t);
+bool is_same_row(Table*, std::size_t, Table*, std::size_t);
+bool is_less_row(Table*, std::size_t, Table*, std::size_t);
+bool is_sorted(Table*);
+std::vector<std::size_t> sort_table(Table*);
+
+// A set of rows, possibly drawn from different tables with the same
+// columns. Rows are hashed by value and compared column by column.
+struct Row_set {
+  bool insert(Table*, std::size_t);
+  bool contains(Table*, std::size_t) const;
+
+  using Row = std::pair<Table*, std::size_t>;
+  std::unordered_map<std::size_t, std::vector<Row>> buckets;
+};
+
+#endif
@@ -39,4 +39,10 @@ init_tokens() {
   init_token(union_tok, "union");
   init_token(intersect_tok, "intersect");
   init_token(except_tok, "except");
+  init_token(index_tok, "index");
+  init_token(group_tok, "group");
+  init_token(count_tok, "count");
+  init_token(sum_tok, "sum");
+  init_token(min_tok, "min");
+  init_token(max_tok, "max");
 }
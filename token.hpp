@@ -59,5 +59,11 @@ constexpr Token_kind on_tok        = make_token(305);
 constexpr Token_kind union_tok     = make_token(306);
 constexpr Token_kind intersect_tok = make_token(307);
 constexpr Token_kind except_tok    = make_token(308);
+constexpr Token_kind index_tok     = make_token(309);
+constexpr Token_kind group_tok     = make_token(310);
+constexpr Token_kind count_tok     = make_token(311);
+constexpr Token_kind sum_tok       = make_token(312);
+constexpr Token_kind min_tok       = make_token(313);
+constexpr Token_kind max_tok       = make_token(314);
 
 #endif
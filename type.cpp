@@ -1,6 +1,13 @@
 
 #include "ast.hpp"
 
+#include "lang/arena.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 
 // -------------------------------------------------------------------------- //
 // Built-in types
@@ -41,6 +48,135 @@ Type*
 get_str_type() { return str_type_; }
 
 
+// -------------------------------------------------------------------------- //
+// Constructed types
+//
+// Constructed types are interned: structurally equal types are the
+// same node, so types are compared by address. A type is identified by
+// its kind and the addresses of its components, which are interned
+// first. The members of a record type are identified by their names
+// and types.
+//
+// Interned types are allocated on the heap, like the built-in types,
+// so that they outlive the arenas of the programs and evaluations that
+// create them. The type table is shared by all threads.
+
+namespace {
+
+using Type_key = std::vector<std::uintptr_t>;
+
+struct Type_key_hash {
+  std::size_t operator()(const Type_key& k) const {
+    std::size_t h = 0;
+    for (std::uintptr_t n : k)
+      h = hash_combine(h, std::hash<std::uintptr_t>()(n));
+    return h;
+  }
+};
+
+std::unordered_map<Type_key, Type*, Type_key_hash> types_;
+std::mutex types_mutex_;
+
+inline std::uintptr_t
+key(const void* p) { return reinterpret_cast<std::uintptr_t>(p); }
+
+// Returns the type identified by k. If there is no such type, it is
+// created by make.
+template<typename F>
+  Type*
+  intern_type(const Type_key& k, F make) {
+    std::lock_guard<std::mutex> lock(types_mutex_);
+    auto iter = types_.find(k);
+    if (iter != types_.end())
+      return iter->second;
+    Arena_guard heap(nullptr);
+    Type* t = make();
+    types_.emplace(k, t);
+    return t;
+  }
+
+// Returns a copy of the sequence of types ts.
+Type_seq*
+copy_types(Type_seq* ts) {
+  Type_seq* copy = new Type_seq();
+  copy->assign(ts->begin(), ts->end());
+  return copy;
+}
+
+} // namespace
+
+// Returns the arrow type 'T1 -> T2'.
+Type*
+get_arrow_type(Type* t1, Type* t2) {
+  Type_key k {arrow_type, key(t1), key(t2)};
+  return intern_type(k, [&]() {
+    return new Arrow_type(kind_type_, t1, t2);
+  });
+}
+
+// Returns the function type '(T1, ..., Tn) -> T'.
+Type*
+get_fn_type(Type_seq* ts, Type* t) {
+  Type_key k {fn_type, key(t)};
+  for (Type* ti : *ts)
+    k.push_back(key(ti));
+  return intern_type(k, [&]() {
+    return new Fn_type(kind_type_, copy_types(ts), t);
+  });
+}
+
+// Returns the tuple type '{T1, ..., Tn}'.
+Type*
+get_tuple_type(Type_seq* ts) {
+  Type_key k {tuple_type};
+  for (Type* ti : *ts)
+    k.push_back(key(ti));
+  return intern_type(k, [&]() {
+    return new Tuple_type(kind_type_, copy_types(ts));
+  });
+}
+
+// Returns the list type '[T]'.
+Type*
+get_list_type(Type* t) {
+  Type_key k {list_type, key(t)};
+  return intern_type(k, [&]() {
+    return new List_type(kind_type_, t);
+  });
+}
+
+// Returns the record type '{n1:T1, ..., nn:Tn}' whose members are the
+// variables in vs. The members of the type are copies of those
+// variables.
+Type*
+get_record_type(Term_seq* vs) {
+  Type_key k {record_type};
+  for (Term* v : *vs) {
+    Var* var = as<Var>(v);
+    k.push_back(key(as<Id>(var->name())->t1.ptr()));
+    k.push_back(key(var->type()));
+  }
+  return intern_type(k, [&]() {
+    Term_seq* ms = new Term_seq();
+    ms->reserve(vs->size());
+    for (Term* v : *vs) {
+      Var* var = as<Var>(v);
+      ms->push_back(new Var(new Id(as<Id>(var->name())->t1), var->type()));
+    }
+    return new Record_type(kind_type_, ms);
+  });
+}
+
+// Returns a new wildcard type named n. Wildcard types are not interned;
+// each is distinct. Like interned types, they are allocated on the
+// heap, since they can be components of interned types.
+Type*
+make_wild_type(Name* n) {
+  Arena_guard heap(nullptr);
+  return new Wild_type(kind_type_, new Id(as<Id>(n)->t1), kind_type_);
+}
+
+
 // -------------------------------------------------------------------------- //
 // Typing
 
@@ -6,6 +6,9 @@
 
 // This module defines support functions for querying the type
 // of an expression.
+//
+// Types are interned, so two types are the same exactly when they are
+// the same node.
 
 Type* get_kind_type();
 Type* get_unit_type();
@@ -13,6 +16,13 @@ Type* get_bool_type();
 Type* get_nat_type();
 Type* get_str_type();
 
+Type* get_arrow_type(Type*, Type*);
+Type* get_fn_type(Type_seq*, Type*);
+Type* get_tuple_type(Type_seq*);
+Type* get_list_type(Type*);
+Type* get_record_type(Term_seq*);
+Type* make_wild_type(Name*);
+
 bool is_type(Expr*);
 bool is_unit_type(Type*);
 bool is_bool_type(Type*);
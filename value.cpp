@@ -14,6 +14,11 @@ Unit* unit_;
 True* true_;
 False* false_;
 
+// The integers less than this are interned.
+constexpr unsigned long small_ints = 256;
+
+Int* ints_[small_ints];
+
 } // namespace
 
 void
@@ -21,6 +26,8 @@ init_values() {
   unit_ = new Unit(get_unit_type());
   true_ = new True(get_bool_type());
   false_ = new False(get_bool_type());
+  for (unsigned long n = 0; n < small_ints; ++n)
+    ints_[n] = new Int(get_nat_type(), Integer(long(n)));
 }
 
 Term*
@@ -32,6 +39,27 @@ get_true() { return true_; }
 Term*
 get_false() { return false_; }
 
+Term*
+get_zero() { return ints_[0]; }
+
+// Returns the integer value n. Small integers are shared; others are
+// allocated as needed.
+Term*
+get_int(unsigned long n) {
+  if (n < small_ints)
+    return ints_[n];
+  return new Int(get_nat_type(), Integer(long(n)));
+}
+
+// Returns the integer value n. Small decimal integers are shared.
+Term*
+get_int(const Integer& n) {
+  const mpz_t& z = n.data();
+  if (n.base() == 10 and mpz_sgn(z) >= 0 and mpz_cmp_ui(z, small_ints) < 0)
+    return ints_[mpz_get_ui(z)];
+  return new Int(get_nat_type(), n);
+}
+
 // -------------------------------------------------------------------------- //
 // Term classification
 //
@@ -70,11 +98,105 @@ is_unit(Term* t) { return t->kind == unit_term; }
 bool
 is_string_value(Term* t) { return t->kind == str_term; }
 
+namespace {
+
+// Returns true when each term in ts is a value.
+bool
+are_values(Term_seq* ts) {
+  for (Term* t : *ts)
+    if (not is_value(t))
+      return false;
+  return true;
+}
+
+} // namespace
+
 // Returns true when t is a list value. A list term is a list value
 // only when t has the form '[v1, ..., vn]' where each 'vi' is a value.
+//
+// Once a list is found to be a value, it is marked as normal, so that
+// its elements are not inspected again. The same holds for tuples and
+// records. Values may be shared by several threads (see par.hpp), so
+// the mark is only ever set, and never cleared.
 bool
 is_list_value(Term* t) {
-  return false;
+  List* l = as<List>(t);
+  if (not l)
+    return false;
+  if (l->normal.load(std::memory_order_relaxed))
+    return true;
+  if (not are_values(l->elems()))
+    return false;
+  l->normal.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+// Returns true when t is a tuple value of the form '{v1, ..., vn}'.
+bool
+is_tuple_value(Term* t) {
+  Tuple* u = as<Tuple>(t);
+  if (not u)
+    return false;
+  if (u->normal.load(std::memory_order_relaxed))
+    return true;
+  if (not are_values(u->elems()))
+    return false;
+  u->normal.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+// Returns true when t is a record value of the form
+// '{n1=v1, ..., nn=vn}'.
+bool
+is_record_value(Term* t) {
+  Record* r = as<Record>(t);
+  if (not r)
+    return false;
+  if (r->normal.load(std::memory_order_relaxed))
+    return true;
+  for (Term* m : *r->members()) {
+    Term* v = as<Term>(as<Init>(m)->value());
+    if (not v or not is_value(v))
+      return false;
+  }
+  r->normal.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+// Returns true when t is a value that contains no abstractions. The
+// abstractions in a tuple, list, or record may refer to the
+// parameters of an enclosing function, so only a ground value can be
+// used without evaluating it in its environment.
+bool
+is_ground_value(Term* t) {
+  switch (t->kind) {
+  case abs_term:
+  case fn_term:
+    return false;
+  case list_term:
+    if (not is_list_value(t))
+      return false;
+    for (Term* e : *as<List>(t)->elems())
+      if (not is_ground_value(e))
+        return false;
+    return true;
+  case tuple_term:
+    if (not is_tuple_value(t))
+      return false;
+    for (Term* e : *as<Tuple>(t)->elems())
+      if (not is_ground_value(e))
+        return false;
+    return true;
+  case record_term:
+    if (not is_record_value(t))
+      return false;
+    for (Term* m : *as<Record>(t)->members())
+      if (not is_ground_value(as<Term>(as<Init>(m)->value())))
+        return false;
+    return true;
+  default:
+    return is_value(t);
+  }
 }
 
 // Returns true if t is a value (in normal form), which is defined
@@ -85,17 +207,28 @@ is_list_value(Term* t) {
 //        | integer-value 
 //        | string-value 
 //        | list-value
+//        | tuple-value
+//        | record-value
+//        | table
 //        | \x:T.t
+//        | \(x1:T1, ..., xn:Tn).t
 //
-// TODO: We're missing value definitions for tuples, records, and
-// variants.
+// TODO: We're missing value definitions for variants.
 bool
 is_value(Term* t) { 
-  return is_unit(t)
-      or is_boolean_value(t) 
-      or is_integer_value(t) 
-      or is_string_value(t)
-      or is_list_value(t)
-      or is_abs(t);
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case table_term:
+  case abs_term:
+  case fn_term:
+    return true;
+  case list_term: return is_list_value(t);
+  case tuple_term: return is_tuple_value(t);
+  case record_term: return is_record_value(t);
+  default: return false;
+  }
 }
-
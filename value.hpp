@@ -3,6 +3,7 @@
 #define VALUE_HPP
 
 struct Term;
+class Integer;
 
 // This module provides support for querying properties related
 // to values.
@@ -11,12 +12,17 @@ Term* get_unit();
 Term* get_true();
 Term* get_false();
 Term* get_zero();
+Term* get_int(unsigned long);
+Term* get_int(const Integer&);
 
 bool is_value(Term*);
 bool is_boolean_value(Term*);
 bool is_integer_value(Term*);
 bool is_string_value(Term*);
 bool is_list_value(Term*);
+bool is_tuple_value(Term*);
+bool is_record_value(Term*);
+bool is_ground_value(Term*);
 
 bool is_true(Term*);
 bool is_false(Term*);
@@ -0,0 +1,995 @@
+#include "vm.hpp"
+#include "eval.hpp"
+#include "type.hpp"
+#include "value.hpp"
+#include "subst.hpp"
+#include "plan.hpp"
+#include "table.hpp"
+
+#include "lang/debug.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+
+// -------------------------------------------------------------------------- //
+// Values
+
+namespace {
+
+inline Value
+make_unit() {
+  Value v;
+  v.kind = unit_value;
+  v.n = 0;
+  return v;
+}
+
+inline Value
+make_bool(bool b) {
+  Value v;
+  v.kind = bool_value;
+  v.n = 0;
+  v.b = b;
+  return v;
+}
+
+inline Value
+make_nat(unsigned long n) {
+  Value v;
+  v.kind = nat_value;
+  v.n = n;
+  return v;
+}
+
+inline Value
+make_term(Term* t) {
+  Value v;
+  v.kind = term_value;
+  v.t = t;
+  return v;
+}
+
+inline Value
+make_closure(Proto* p, Frame* e) {
+  Value v;
+  v.kind = closure_value;
+  v.c = new_in_arena<Vm_closure>(Vm_closure{p, e});
+  return v;
+}
+
+std::size_t compile_fn(Vm_program*, Term*);
+
+// Returns the value of the term t. Natural numbers that fit in a word
+// are unboxed, and functions are compiled.
+Value
+from_term(Vm_program* p, Term* t) {
+  if (not t)
+    return make_term(t);
+  switch (t->kind) {
+  case unit_term:
+    return make_unit();
+  case true_term:
+    return make_bool(true);
+  case false_term:
+    return make_bool(false);
+  case int_term: {
+    const mpz_t& z = as<Int>(t)->value().data();
+    if (mpz_fits_slong_p(z))
+      return make_nat(mpz_get_ui(z));
+    return make_term(t);
+  }
+  case abs_term:
+  case fn_term:
+    return make_closure(p->protos[compile_fn(p, t)], nullptr);
+  default:
+    return make_term(t);
+  }
+}
+
+Term* to_term(const Value&);
+
+// Returns the function of the closure c with the arguments in its
+// frames substituted for their parameters.
+Term*
+reify(Vm_closure* c) {
+  if (not c->env)
+    return c->proto->fn;
+  Subst sub;
+  for (Frame* f = c->env; f; f = f->parent)
+    for (std::size_t i = 0; i < f->slots.size(); ++i)
+      sub.insert({f->proto->parms[i], to_term(f->slots[i])});
+  return subst_term(c->proto->fn, sub);
+}
+
+// Returns the value v as a term.
+Term*
+to_term(const Value& v) {
+  switch (v.kind) {
+  case unit_value:
+    return get_unit();
+  case bool_value:
+    return v.b ? get_true() : get_false();
+  case nat_value:
+    return get_int(v.n);
+  case term_value:
+    return v.t;
+  case closure_value:
+    return reify(v.c);
+  }
+  lang_unreachable("unknown value");
+}
+
+// Returns true when a and b are the same value.
+bool
+is_same(const Value& a, const Value& b) {
+  if (a.kind == b.kind) {
+    switch (a.kind) {
+    case unit_value: return true;
+    case bool_value: return a.b == b.b;
+    case nat_value: return a.n == b.n;
+    default: break;
+    }
+  }
+  return is_same(to_term(a), to_term(b));
+}
+
+// Returns true when a is less than b.
+bool
+is_less(const Value& a, const Value& b) {
+  if (a.kind == nat_value and b.kind == nat_value)
+    return a.n < b.n;
+  return is_less(to_term(a), to_term(b));
+}
+
+} // namespace
+
+
+// -------------------------------------------------------------------------- //
+// Compilation
+//
+// A term is compiled into code that leaves its value on the stack.
+// References to parameters are compiled using the depth and slot
+// recorded during elaboration: the arguments of the function being
+// compiled are on the stack, and those of enclosing functions are in
+// the frames of the closure.
+
+namespace {
+
+// The compilation of a function body. The functions enclosing the
+// body are being compiled, innermost last.
+struct Compiler {
+  Compiler(Vm_program* p)
+    : prog(p) { }
+
+  void compile(Term*);
+  void compile_tail(Term*);
+  void compile_int(Int*);
+  void compile_if(If*);
+  void compile_ref(Ref*);
+  void compile_def(Def*);
+  void compile_print(Print*);
+  void compile_prog(Prog*);
+  void compile_elems(Term*, Term_seq*, Opcode);
+  void compile_set(Term*, Term*, Term*);
+  void compile_var(int, int);
+  void compile_term(Term*);
+
+  void emit(int);
+  void emit(int, int);
+  void emit(int, int, int);
+  std::size_t here() const;
+
+  Vm_program* prog;
+  std::vector<Proto*> protos;
+};
+
+void
+Compiler::emit(int op) {
+  protos.back()->code.push_back(op);
+}
+
+void
+Compiler::emit(int op, int a) {
+  emit(op);
+  emit(a);
+}
+
+void
+Compiler::emit(int op, int a, int b) {
+  emit(op, a);
+  emit(b);
+}
+
+// Returns the position of the next instruction.
+std::size_t
+Compiler::here() const {
+  return protos.back()->code.size();
+}
+
+// Returns true when the term t is compiled to bytecode. Other terms
+// are evaluated by the reference rules.
+bool
+is_compiled(Term* t) {
+  switch (t->kind) {
+  case unit_term:
+  case true_term:
+  case false_term:
+  case int_term:
+  case str_term:
+  case table_term:
+  case if_term:
+  case and_term:
+  case or_term:
+  case not_term:
+  case equals_term:
+  case less_term:
+  case succ_term:
+  case pred_term:
+  case iszero_term:
+  case abs_term:
+  case fn_term:
+  case app_term:
+  case call_term:
+  case ref_term:
+  case def_term:
+  case print_term:
+  case prog_term:
+  case comma_term:
+  case tuple_term:
+  case list_term:
+  case record_term:
+  case mem_term:
+  case proj_term:
+    return true;
+  case union_term:
+  case intersect_term:
+  case except_term:
+    return not is_query(t);
+  default:
+    return false;
+  }
+}
+
+// Returns the index of a new constant value.
+int
+add_const(Vm_program* p, const Value& v) {
+  p->consts.push_back(v);
+  return p->consts.size() - 1;
+}
+
+// Natural numbers that fit in an operand are pushed directly. Others
+// are constants.
+void
+Compiler::compile_int(Int* t) {
+  Value v = from_term(prog, t);
+  if (v.kind == nat_value and v.n <= INT_MAX)
+    emit(push_nat_op, v.n);
+  else
+    emit(push_const_op, add_const(prog, v));
+}
+
+// Compile 'if t1 then t2 else t3' as:
+//
+//        t1
+//        jump_false L1
+//        t2
+//        jump L2
+//    L1: t3
+//    L2:
+void
+Compiler::compile_if(If* t) {
+  compile(t->cond());
+  emit(jump_false_op, 0);
+  std::size_t j1 = here() - 1;
+  compile(t->if_true());
+  emit(jump_op, 0);
+  std::size_t j2 = here() - 1;
+  protos.back()->code[j1] = here();
+  compile(t->if_false());
+  protos.back()->code[j2] = here();
+}
+
+// Push the argument in the given slot of the function depth levels
+// above the function being compiled. The arguments of the function
+// being compiled are on the stack. Those of an enclosing function are
+// in the frames of the closure.
+void
+Compiler::compile_var(int depth, int slot) {
+  if (depth == 0)
+    emit(load_local_op, slot);
+  else
+    emit(load_env_op, depth - 1, slot);
+}
+
+// References to parameters push their arguments, and references to
+// definitions push their values. Any other reference, including one
+// to a definition whose value is not a term (e.g., a type), is its
+// own value.
+void
+Compiler::compile_ref(Ref* t) {
+  if (t->depth >= 0) {
+    compile_var(t->depth, t->slot);
+    return;
+  }
+  if (Def* d = as<Def>(t->decl())) {
+    auto iter = prog->def_index.find(d);
+    if (iter != prog->def_index.end() and as<Term>(d->value())) {
+      emit(load_def_op, iter->second);
+      return;
+    }
+  }
+  emit(push_const_op, add_const(prog, make_term(t)));
+}
+
+// Compile the value of the definition, then store it.
+void
+Compiler::compile_def(Def* t) {
+  Term* t0 = as<Term>(t->value());
+  if (not t0) {
+    emit(push_const_op, add_const(prog, make_term(t)));
+    return;
+  }
+  std::size_t k = prog->defs.size();
+  prog->defs.push_back(t);
+  prog->globals.push_back(make_unit());
+  prog->def_index[t] = k;
+  compile(t0);
+  emit(store_def_op, k);
+}
+
+// Print the value of the term. Queries, whose rows are printed as they
+// are produced, and other terms that are not compiled, are printed by
+// the reference rules.
+void
+Compiler::compile_print(Print* t) {
+  Term* t0 = as<Term>(t->expr());
+  if (not t0 or is_query(t0) or not is_compiled(t0)) {
+    compile_term(t);
+    return;
+  }
+  compile(t0);
+  emit(print_op);
+}
+
+// Compile each statement, keeping the value of the last.
+void
+Compiler::compile_prog(Prog* t) {
+  Term_seq* ss = t->stmts();
+  if (ss->empty()) {
+    emit(push_unit_op);
+    return;
+  }
+  for (std::size_t i = 0; i < ss->size(); ++i) {
+    if (i != 0)
+      emit(pop_op);
+    compile((*ss)[i]);
+  }
+}
+
+// Compile a tuple, list, or record t whose elements are ts as:
+//
+//        t1
+//        ...
+//        tn
+//        op k n
+//
+// where the kth constant is t, which gives the type of the result and
+// the names of the members of a record. Values are constants, except
+// for lists of records, which are stored as tables when they are
+// evaluated, and values with abstractions, which are closed over the
+// current frame.
+void
+Compiler::compile_elems(Term* t, Term_seq* ts, Opcode op) {
+  if (is_ground_value(t) and not is_table_type(get_type(t))) {
+    emit(push_const_op, add_const(prog, make_term(t)));
+    return;
+  }
+  for (Term* e : *ts) {
+    if (Init* i = as<Init>(e))
+      compile(as<Term>(i->value()));
+    else
+      compile(e);
+  }
+  emit(op, add_const(prog, make_term(t)), ts->size());
+}
+
+// Compile the set operation t on t1 and t2 as:
+//
+//        t1
+//        t2
+//        set_op k
+//
+// where the kth constant is t.
+void
+Compiler::compile_set(Term* t, Term* t1, Term* t2) {
+  compile(t1);
+  compile(t2);
+  emit(set_op, add_const(prog, make_term(t)));
+}
+
+// Compile a term that is evaluated by the reference rules. The
+// arguments of every enclosing function are pushed, so they can be
+// substituted into the term.
+void
+Compiler::compile_term(Term* t) {
+  Vm_term vt {t, {}};
+  for (std::size_t i = 0; i < protos.size(); ++i) {
+    const std::vector<Var*>& ps = protos[i]->parms;
+    for (std::size_t s = 0; s < ps.size(); ++s) {
+      compile_var(protos.size() - 1 - i, s);
+      vt.vars.push_back(ps[s]);
+    }
+  }
+  prog->terms.push_back(vt);
+  emit(term_op, prog->terms.size() - 1, vt.vars.size());
+}
+
+void
+Compiler::compile(Term* t) {
+  switch (t->kind) {
+  case unit_term:
+  case comma_term:
+    return emit(push_unit_op);
+  case true_term:
+    return emit(push_true_op);
+  case false_term:
+    return emit(push_false_op);
+  case int_term:
+    return compile_int(as<Int>(t));
+  case str_term:
+  case table_term:
+    return emit(push_const_op, add_const(prog, make_term(t)));
+  case if_term:
+    return compile_if(as<If>(t));
+  case and_term: {
+    And* t0 = as<And>(t);
+    compile(t0->t1);
+    compile(t0->t2);
+    return emit(and_op);
+  }
+  case or_term: {
+    Or* t0 = as<Or>(t);
+    compile(t0->t1);
+    compile(t0->t2);
+    return emit(or_op);
+  }
+  case equals_term: {
+    Equals* t0 = as<Equals>(t);
+    compile(t0->t1);
+    compile(t0->t2);
+    return emit(eq_op);
+  }
+  case less_term: {
+    Less* t0 = as<Less>(t);
+    compile(t0->t1);
+    compile(t0->t2);
+    return emit(less_op);
+  }
+  case not_term:
+    compile(as<Not>(t)->t1);
+    return emit(not_op);
+  case succ_term:
+    compile(as<Succ>(t)->arg());
+    return emit(succ_op);
+  case pred_term:
+    compile(as<Pred>(t)->arg());
+    return emit(pred_op);
+  case iszero_term:
+    compile(as<Iszero>(t)->arg());
+    return emit(iszero_op);
+  case abs_term:
+  case fn_term:
+    return emit(closure_op, compile_fn(prog, t));
+  case app_term: {
+    App* t0 = as<App>(t);
+    compile(t0->abs());
+    compile(t0->arg());
+    return emit(call_op, 1);
+  }
+  case call_term: {
+    Call* t0 = as<Call>(t);
+    compile(t0->fn());
+    for (Term* a : *t0->args())
+      compile(a);
+    return emit(call_op, t0->args()->size());
+  }
+  case ref_term:
+    return compile_ref(as<Ref>(t));
+  case def_term:
+    return compile_def(as<Def>(t));
+  case print_term:
+    return compile_print(as<Print>(t));
+  case prog_term:
+    return compile_prog(as<Prog>(t));
+  case tuple_term:
+    return compile_elems(t, as<Tuple>(t)->elems(), tuple_op);
+  case list_term:
+    return compile_elems(t, as<List>(t)->elems(), list_op);
+  case record_term:
+    return compile_elems(t, as<Record>(t)->members(), record_op);
+  case mem_term:
+    compile(as<Mem>(t)->record());
+    return emit(mem_op, add_const(prog, make_term(t)));
+  case proj_term:
+    compile(as<Proj>(t)->tuple());
+    return emit(proj_op, add_const(prog, make_term(t)));
+  case union_term:
+    if (is_query(t))
+      return compile_term(t);
+    return compile_set(t, as<Union>(t)->t1, as<Union>(t)->t2);
+  case intersect_term:
+    if (is_query(t))
+      return compile_term(t);
+    return compile_set(t, as<Intersect>(t)->t1, as<Intersect>(t)->t2);
+  case except_term:
+    if (is_query(t))
+      return compile_term(t);
+    return compile_set(t, as<Except>(t)->t1, as<Except>(t)->t2);
+  default:
+    return compile_term(t);
+  }
+}
+
+// Compile the body of a function, returning its value. The branches
+// of an if, and applications and calls, are in tail position: a call
+// in tail position replaces the activation of the function instead of
+// returning to it.
+void
+Compiler::compile_tail(Term* t) {
+  switch (t->kind) {
+  case if_term: {
+    If* t0 = as<If>(t);
+    compile(t0->cond());
+    emit(jump_false_op, 0);
+    std::size_t j = here() - 1;
+    compile_tail(t0->if_true());
+    protos.back()->code[j] = here();
+    return compile_tail(t0->if_false());
+  }
+  case app_term: {
+    App* t0 = as<App>(t);
+    compile(t0->abs());
+    compile(t0->arg());
+    return emit(tail_call_op, 1);
+  }
+  case call_term: {
+    Call* t0 = as<Call>(t);
+    compile(t0->fn());
+    for (Term* a : *t0->args())
+      compile(a);
+    return emit(tail_call_op, t0->args()->size());
+  }
+  default:
+    compile(t);
+    return emit(ret_op);
+  }
+}
+
+// The functions being compiled, innermost last. Functions compiled
+// while the program is running are closed, so they are compiled
+// outside of any other function.
+std::vector<Proto*> enclosing;
+
+// Returns the index of the compiled function t, compiling it if
+// needed. The body of the function is compiled within the functions
+// enclosing it.
+std::size_t
+compile_fn(Vm_program* p, Term* t) {
+  auto iter = p->fns.find(t);
+  if (iter != p->fns.end())
+    return iter->second;
+
+  Proto* proto = new_in_arena<Proto>(t);
+  Term* body;
+  if (Abs* abs = as<Abs>(t)) {
+    proto->parms.push_back(as<Var>(abs->var()));
+    body = abs->term();
+  } else {
+    Fn* fn = as<Fn>(t);
+    for (Term* v : *fn->parms())
+      proto->parms.push_back(as<Var>(v));
+    body = fn->term();
+  }
+  std::size_t n = p->protos.size();
+  p->protos.push_back(proto);
+  p->fns[t] = n;
+
+  Compiler comp(p);
+  comp.protos = enclosing;
+  comp.protos.push_back(proto);
+  enclosing.push_back(proto);
+  comp.compile_tail(body);
+  enclosing.pop_back();
+  return n;
+}
+
+} // namespace
+
+// Compile the program t. The program is the first function of the
+// result.
+Vm_program*
+compile(Term* t) {
+  Vm_program* p = new_in_arena<Vm_program>();
+  Proto* proto = new_in_arena<Proto>(t);
+  p->protos.push_back(proto);
+
+  Compiler comp(p);
+  comp.protos.push_back(proto);
+  enclosing.push_back(proto);
+  comp.compile(t);
+  comp.emit(ret_op);
+  enclosing.pop_back();
+  return p;
+}
+
+
+// -------------------------------------------------------------------------- //
+// Execution
+
+namespace {
+
+// The state of a function call. The frame of the call is created
+// when the call creates a closure.
+struct Activation {
+  Proto* proto;
+  std::size_t ip;
+  std::size_t bp;
+  Frame* env;
+  Frame* frame;
+};
+
+// Returns the successor of the natural number v.
+Value
+succ(const Value& v) {
+  if (v.kind == nat_value) {
+    if (v.n < LONG_MAX)
+      return make_nat(v.n + 1);
+    return make_term(get_int(Integer(long(v.n)) + Integer(1l)));
+  }
+  if (Int* n = as<Int>(v.t))
+    return make_term(get_int(n->value() + Integer(1l)));
+  lang_unreachable(format("'{}' is not a numeric value", pretty(to_term(v))));
+}
+
+// Returns the predecessor of the natural number v.
+Value
+pred(Vm_program* p, const Value& v) {
+  if (v.kind == nat_value)
+    return make_nat(v.n ? v.n - 1 : 0);
+  if (Int* n = as<Int>(v.t))
+    return from_term(p, get_int(n->value() - Integer(1l)));
+  lang_unreachable(format("'{}' is not a numeric value", pretty(to_term(v))));
+}
+
+// Returns the value of the boolean v.
+inline bool
+get_bool(const Value& v) {
+  lang_assert(v.kind == bool_value, format("'{}' is not a boolean value", pretty(to_term(v))));
+  return v.b;
+}
+
+// Returns the top n values of the stack as terms, in order, and pops
+// them.
+Term_seq*
+pop_terms(std::vector<Value>& stack, int n) {
+  Term_seq* ts = new Term_seq();
+  ts->reserve(n);
+  for (std::size_t i = stack.size() - n; i < stack.size(); ++i)
+    ts->push_back(to_term(stack[i]));
+  stack.resize(stack.size() - n);
+  return ts;
+}
+
+// Returns the record t with the values vs for its members, in order.
+Record*
+make_record(Record* t, Term_seq* vs) {
+  Term_seq* ms = t->members();
+  for (std::size_t i = 0; i < ms->size(); ++i) {
+    Init* m = as<Init>((*ms)[i]);
+    (*vs)[i] = new Init(m->loc, get_type(m), m->name(), (*vs)[i]);
+  }
+  Record* r = new Record(t->loc, get_type(t), vs);
+  r->normal = true;
+  return r;
+}
+
+// Returns the value of the member of the record or table v named by
+// the projection t. Members of tables are found by the reference
+// rules.
+Value
+get_member(Vm_program* p, Mem* t, const Value& v) {
+  Record* r = v.kind == term_value ? as<Record>(v.t) : nullptr;
+  if (r) {
+    Name* n = as<Var>(as<Ref>(t->member())->decl())->name();
+    for (Term* m : *r->members())
+      if (is_same(n, as<Init>(m)->name()))
+        return from_term(p, as<Term>(as<Init>(m)->value()));
+  }
+  return from_term(p, eval(new Mem(t->loc, get_type(t), to_term(v), t->member())));
+}
+
+// Returns the set operation t on the values v1 and v2, computed by
+// the reference rules.
+Value
+get_set(Vm_program* p, Term* t, const Value& v1, const Value& v2) {
+  Term* t1 = to_term(v1);
+  Term* t2 = to_term(v2);
+  switch (t->kind) {
+  case union_term:
+    return from_term(p, eval(new Union(t->loc, get_type(t), t1, t2)));
+  case intersect_term:
+    return from_term(p, eval(new Intersect(t->loc, get_type(t), t1, t2)));
+  case except_term:
+    return from_term(p, eval(new Except(t->loc, get_type(t), t1, t2)));
+  default:
+    break;
+  }
+  lang_unreachable(format("'{}' is not a set operation", pretty(t)));
+}
+
+// Evaluate the kth term, substituting the top n values of the stack
+// for its variables.
+Value
+eval_term(Vm_program* p, std::vector<Value>& stack, int k, int n) {
+  const Vm_term& vt = p->terms[k];
+  Term* t = vt.term;
+  if (n) {
+    Subst sub;
+    for (int i = 0; i < n; ++i)
+      sub.insert({vt.vars[i], to_term(stack[stack.size() - n + i])});
+    t = subst_term(t, sub);
+    stack.resize(stack.size() - n);
+  }
+  return from_term(p, eval(t));
+}
+
+} // namespace
+
+// Run the program p, returning its value as a term.
+Term*
+run(Vm_program* p) {
+  std::vector<Value> stack;
+  std::vector<Activation> calls;
+  Activation a {p->protos[0], 0, 0, nullptr, nullptr};
+  const int* code = a.proto->code.data();
+
+  for (;;) {
+    switch (code[a.ip++]) {
+    case push_unit_op:
+      stack.push_back(make_unit());
+      break;
+
+    case push_true_op:
+      stack.push_back(make_bool(true));
+      break;
+
+    case push_false_op:
+      stack.push_back(make_bool(false));
+      break;
+
+    case push_nat_op:
+      stack.push_back(make_nat(code[a.ip++]));
+      break;
+
+    case push_const_op:
+      stack.push_back(p->consts[code[a.ip++]]);
+      break;
+
+    case load_local_op:
+      stack.push_back(stack[a.bp + code[a.ip++]]);
+      break;
+
+    case load_env_op: {
+      Frame* f = a.env;
+      for (int d = code[a.ip++]; d != 0; --d)
+        f = f->parent;
+      stack.push_back(f->slots[code[a.ip++]]);
+      break;
+    }
+
+    case load_def_op:
+      stack.push_back(p->globals[code[a.ip++]]);
+      break;
+
+    case store_def_op: {
+      int k = code[a.ip++];
+      Def* d = p->defs[k];
+      p->globals[k] = stack.back();
+      d->t2 = to_term(stack.back());
+      stack.back() = make_term(d);
+      break;
+    }
+
+    case closure_op: {
+      // Functions created by the program itself are closed.
+      Proto* f = p->protos[code[a.ip++]];
+      if (calls.empty()) {
+        stack.push_back(make_closure(f, nullptr));
+        break;
+      }
+      if (not a.frame) {
+        std::size_t n = a.proto->parms.size();
+        a.frame = new_in_arena<Frame>(a.proto, a.env);
+        a.frame->slots.assign(stack.begin() + a.bp, stack.begin() + a.bp + n);
+      }
+      stack.push_back(make_closure(f, a.frame));
+      break;
+    }
+
+    case pop_op:
+      stack.pop_back();
+      break;
+
+    case jump_op:
+      a.ip = code[a.ip];
+      break;
+
+    case jump_false_op: {
+      bool b = get_bool(stack.back());
+      stack.pop_back();
+      if (b)
+        ++a.ip;
+      else
+        a.ip = code[a.ip];
+      break;
+    }
+
+    case not_op:
+      stack.back() = make_bool(not get_bool(stack.back()));
+      break;
+
+    case and_op: {
+      bool b = get_bool(stack.back());
+      stack.pop_back();
+      stack.back() = make_bool(get_bool(stack.back()) and b);
+      break;
+    }
+
+    case or_op: {
+      bool b = get_bool(stack.back());
+      stack.pop_back();
+      stack.back() = make_bool(get_bool(stack.back()) or b);
+      break;
+    }
+
+    case eq_op: {
+      Value v = stack.back();
+      stack.pop_back();
+      stack.back() = make_bool(is_same(stack.back(), v));
+      break;
+    }
+
+    case less_op: {
+      Value v = stack.back();
+      stack.pop_back();
+      stack.back() = make_bool(is_less(stack.back(), v));
+      break;
+    }
+
+    case succ_op:
+      stack.back() = succ(stack.back());
+      break;
+
+    case pred_op:
+      stack.back() = pred(p, stack.back());
+      break;
+
+    case iszero_op: {
+      const Value& v = stack.back();
+      if (v.kind == nat_value)
+        stack.back() = make_bool(v.n == 0);
+      else if (is<Int>(v.t))
+        stack.back() = make_bool(false);
+      else
+        lang_unreachable(format("'{}' is not a numeric value", pretty(to_term(v))));
+      break;
+    }
+
+    case call_op: {
+      int n = code[a.ip++];
+      const Value& f = stack[stack.size() - n - 1];
+      lang_assert(f.kind == closure_value, format("ill-formed call target '{}'", pretty(to_term(f))));
+      lang_assert(f.c->proto->parms.size() == std::size_t(n), "wrong number of arguments");
+      calls.push_back(a);
+      a = {f.c->proto, 0, stack.size() - n, f.c->env, nullptr};
+      code = a.proto->code.data();
+      break;
+    }
+
+    case tail_call_op: {
+      // Move the function and its arguments over those of the
+      // current call, and reuse its activation.
+      int n = code[a.ip++];
+      std::size_t f = stack.size() - n - 1;
+      Value c = stack[f];
+      lang_assert(c.kind == closure_value, format("ill-formed call target '{}'", pretty(to_term(c))));
+      lang_assert(c.c->proto->parms.size() == std::size_t(n), "wrong number of arguments");
+      std::copy(stack.begin() + f, stack.end(), stack.begin() + a.bp - 1);
+      stack.resize(a.bp + n);
+      a = {c.c->proto, 0, a.bp, c.c->env, nullptr};
+      code = a.proto->code.data();
+      break;
+    }
+
+    case ret_op: {
+      Value v = stack.back();
+      if (calls.empty())
+        return to_term(v);
+      stack.resize(a.bp - 1);
+      stack.push_back(v);
+      a = calls.back();
+      calls.pop_back();
+      code = a.proto->code.data();
+      break;
+    }
+
+    case print_op:
+      std::cout << pretty(to_term(stack.back())) << '\n';
+      stack.back() = make_unit();
+      break;
+
+    case tuple_op: {
+      Tuple* t = as<Tuple>(p->consts[code[a.ip++]].t);
+      Tuple* v = new Tuple(t->loc, get_type(t), pop_terms(stack, code[a.ip++]));
+      v->normal = true;
+      stack.push_back(make_term(v));
+      break;
+    }
+
+    case list_op: {
+      // A list of records is stored as a table.
+      List* t = as<List>(p->consts[code[a.ip++]].t);
+      List* v = new List(t->loc, get_type(t), pop_terms(stack, code[a.ip++]));
+      v->normal = true;
+      stack.push_back(make_term(is_table_type(get_type(t)) ? eval(v) : v));
+      break;
+    }
+
+    case record_op: {
+      Record* t = as<Record>(p->consts[code[a.ip++]].t);
+      stack.push_back(make_term(make_record(t, pop_terms(stack, code[a.ip++]))));
+      break;
+    }
+
+    case mem_op: {
+      Mem* t = as<Mem>(p->consts[code[a.ip++]].t);
+      stack.back() = get_member(p, t, stack.back());
+      break;
+    }
+
+    case proj_op: {
+      Proj* t = as<Proj>(p->consts[code[a.ip++]].t);
+      Term* v = to_term(stack.back());
+      stack.back() = from_term(p, eval(new Proj(t->loc, get_type(t), v, t->elem())));
+      break;
+    }
+
+    case set_op: {
+      Term* t = p->consts[code[a.ip++]].t;
+      Value v = stack.back();
+      stack.pop_back();
+      stack.back() = get_set(p, t, stack.back(), v);
+      break;
+    }
+
+    case term_op: {
+      int k = code[a.ip++];
+      int n = code[a.ip++];
+      Value v = eval_term(p, stack, k, n);
+      stack.push_back(v);
+      break;
+    }
+
+    default:
+      lang_unreachable("unknown instruction");
+    }
+  }
+}
+
+// Compute the evaluation of the term t by compiling it to bytecode
+// and running the result.
+Term*
+eval_vm(Term* t) {
+  return run(compile(t));
+}
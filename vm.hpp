@@ -0,0 +1,142 @@
+
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "ast.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// This module defines a compiler from elaborated terms to a compact,
+// linear bytecode, and a virtual machine that executes it. Values
+// are unboxed where possible, so evaluating the core language does
+// not allocate terms for booleans and natural numbers. The evaluator
+// in eval.hpp remains the reference semantics.
+
+// -------------------------------------------------------------------------- //
+// Values
+
+struct Frame;
+struct Proto;
+
+// The kinds of values in the machine.
+enum Value_kind : unsigned char {
+  unit_value,    // unit
+  bool_value,    // true or false
+  nat_value,     // A natural number that fits in a machine word
+  term_value,    // Any other value (e.g., strings, records, and tables)
+  closure_value, // A function and the frame it was created in
+};
+
+// A function value. The environment is the frame of the function in
+// which the closure was created, if any. Closures, frames, functions,
+// and programs are allocated in the current arena (see new_in_arena).
+struct Vm_closure {
+  Proto* proto;
+  Frame* env;
+};
+
+// A value of the machine. Only the member selected by the kind is
+// used.
+struct Value {
+  Value_kind kind;
+  union {
+    bool b;
+    unsigned long n;
+    Term* t;
+    Vm_closure* c;
+  };
+};
+
+// A frame holds the arguments of a function call that created a
+// closure, so that the closure can refer to them after the call
+// returns. Arguments are otherwise read from the stack of the machine.
+struct Frame {
+  Frame(Proto* p, Frame* e)
+    : proto(p), parent(e) { }
+
+  Proto* proto;
+  Frame* parent;
+  std::vector<Value> slots;
+};
+
+
+// -------------------------------------------------------------------------- //
+// Bytecode
+
+// The instructions of the machine. Operands follow the opcode in the
+// code of a function.
+enum Opcode : int {
+  push_unit_op,    // push unit
+  push_true_op,    // push true
+  push_false_op,   // push false
+  push_nat_op,     // n: push the natural number n
+  push_const_op,   // k: push the kth constant
+  load_local_op,   // s: push the sth argument of the current call
+  load_env_op,     // d s: push the sth argument in the dth enclosing frame
+  load_def_op,     // k: push the value of the kth definition
+  store_def_op,    // k: define the kth definition as the popped value
+  closure_op,      // p: push a closure of the pth function
+  pop_op,          // pop a value
+  jump_op,         // a: continue at a
+  jump_false_op,   // a: pop a value and continue at a if it is false
+  not_op,          // not v
+  and_op,          // v1 and v2
+  or_op,           // v1 or v2
+  eq_op,           // v1 eq v2
+  less_op,         // v1 lt v2
+  succ_op,         // succ v
+  pred_op,         // pred v
+  iszero_op,       // iszero v
+  call_op,         // n: call the function below the top n values
+  tail_call_op,    // n: call the function below the top n values, in place
+  ret_op,          // return the top value
+  print_op,        // print the popped value, and push unit
+  tuple_op,        // k n: push a tuple of the top n values, like the kth constant
+  list_op,         // k n: push a list of the top n values, like the kth constant
+  record_op,       // k n: push a record of the top n values, like the kth constant
+  mem_op,          // k: project the member of the kth constant from the top value
+  proj_op,         // k: project the element of the kth constant from the top value
+  set_op,          // k: the set operation of the kth constant on the top two values
+  term_op,         // k n: evaluate the kth term with the top n values
+};
+
+// A function compiled to bytecode. The parameters of the function are
+// given by their variable declarations. The program itself is compiled
+// as a function with no parameters.
+struct Proto {
+  Proto(Term* f)
+    : fn(f) { }
+
+  Term* fn;
+  std::vector<Var*> parms;
+  std::vector<int> code;
+};
+
+// A term that is not compiled to bytecode. The term is evaluated by
+// substituting the values of the given variables, which are on the
+// stack, and then evaluating the result.
+struct Vm_term {
+  Term* term;
+  std::vector<Var*> vars;
+};
+
+// A program compiled to bytecode. The first function is the program
+// itself. The values of definitions are stored with the program, in
+// the order they are defined.
+struct Vm_program {
+  std::vector<Proto*> protos;
+  std::vector<Value> consts;
+  std::vector<Vm_term> terms;
+  std::vector<Def*> defs;
+  std::vector<Value> globals;
+  std::unordered_map<Term*, std::size_t> fns;
+  std::unordered_map<Def*, std::size_t> def_index;
+};
+
+Vm_program* compile(Term*);
+Term* run(Vm_program*);
+
+Term* eval_vm(Term*);
+
+#endif